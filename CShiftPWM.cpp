@@ -24,112 +24,420 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "CShiftPWM.h"
 #include <Arduino.h>
 
-CShiftPWM::CShiftPWM(int timerInUse, bool noSPI, int latchPin, int dataPin, int clockPin) :  // Constants are set in initializer list
-					m_timer(timerInUse), m_noSPI(noSPI), m_latchPin(latchPin), m_dataPin(dataPin), m_clockPin(clockPin){
+// Returns value*(scale+1)/256: a scale of 255 keeps the value, 0 gives 0. Used by the functions that change all values at once.
+// On AVRs with a hardware multiplier (not the ATtiny), this is one 2 cycle multiply of two bytes, of which the high byte is used.
+static inline unsigned char ShiftPWM_scale8(unsigned char value, unsigned char scale) __attribute__((always_inline));
+static inline unsigned char ShiftPWM_scale8(unsigned char value, unsigned char scale){
+	#if defined(__AVR_HAVE_MUL__)
+	unsigned char result;
+	asm (
+		"mul %1, %2"		"\n\t"	// r1:r0 = value*scale
+		"add __tmp_reg__, %1"	"\n\t"	// + value
+		"clr %0"			"\n\t"	// does not change the carry
+		"adc %0, r1"		"\n\t"	// result = high byte
+		"clr __zero_reg__"	"\n\t"	// r1 is the zero register of gcc
+		: "=&r" (result)
+		: "r" (value), "r" (scale)
+	);
+	return result;
+	#else
+	return ((unsigned int) value*scale + value)>>8;
+	#endif
+}
+
+#if defined(__AVR__)
+// Prints a number in tenths with one decimal, for PrintInterruptLoad, which does not use floating point.
+static void PrintTenths(unsigned long tenths){
+	Serial.print(tenths/10);
+	Serial.print('.');
+	Serial.print(tenths%10);
+}
+#endif
+
+CShiftPWM::CShiftPWM(int timerInUse, bool noSPI, int latchPin, int dataPin, int clockPin, unsigned char * buffer, unsigned int maxRegisters, bool hardwareLatch) :  // Constants are set in initializer list
+					m_timer(timerInUse), m_noSPI(noSPI), m_latchPin(latchPin), m_dataPin(dataPin), m_clockPin(clockPin), m_hardwareLatch(hardwareLatch){
 	m_ledFrequency = 0;
 	m_maxBrightness = 0;
 	m_amountOfRegisters = 0;
 	m_amountOfOutputs = 0;
+	m_activeRegisters = 0;
+	m_activeOutputs = 0;
+	m_amountOfRows = 1;
+	m_activeRows = 1;
+	m_currentRow = 0;
+	m_rowStart = 0;
+	m_viewStart = 0;
+	m_activeStart = 0;
+	m_viewRow = 0;
+	m_bamBits = 0;
+	m_bamMask = 0;
+	m_bamTicks = 0;
+	m_bamLongest = 0;
+	m_backValues = 0;
+	m_swapPending = false;
 	m_counter = 0;
 	m_pinGrouping = 1; // Default = RGBRGBRGB... PinGrouping = 3 means: RRRGGGBBBRRRGGGBBB...
-
-	unsigned char * m_PWMValues=0;
+	m_channelMap = 0;
+	m_amountOfChannels = 0;
+	m_channelMapLength = 0;
+	#if defined(__AVR__)
+	m_timerClock = ShiftPWM_timerClock(timerInUse);
+	#else
+	m_timerClock = 0;
+	m_interruptEnabled = false;
+	#endif
+	m_oePin = -1;
+	m_masterBrightness = 255;
+	m_currentBudget = 0;
+	m_outputCurrent = 0;
+	m_dutyLimit = 0;
+	m_budgetScale = 256;
+	m_dutySum = 0;
+	m_dutyIntegral = 0;
+	m_partialOutputs = 0;
+	m_idleShutdown = false;
+	m_idle = false;
+	m_idleStart = 0;
+	m_idleDutySum = 0;
+	m_governorMinFrequency = 0;
+	m_governorMaxLoopMicros = 0;
+	m_userDemand = 0;
+	m_loopDemand = 0;
+	m_governorDemand = 0;
+	m_lastLoopMicros = 0;
+	m_governedFrequency = 0;
+	m_onTimeMicros = 0;
+	m_frameCount = 0;
+	m_frameCallback = 0;
+	m_lastFrameSeen = 0;
+
+	m_errorCallback = 0;
+	ClearErrors();
+
+	// If no buffer is given, it is allocated on the heap by SetAmountOfRegisters
+	m_PWMValues = buffer;
+	m_maxRegisters = (buffer!=0) ? maxRegisters : 0;
+	m_bufferOnHeap = false;
+
+	// All registers are PWM registers, until SetRegisterClasses is called
+	m_registerClasses = 0;
+	m_binaryValues = 0;
+	m_binaryRegisters = 0;
+	m_maxBinaryRegisters = 0;
+	m_binaryOnHeap = false;
+	m_fixedRegisters = false;
 }
 
 CShiftPWM::~CShiftPWM() {
-	if(m_PWMValues>0){
+	if(m_bufferOnHeap){
 		free( m_PWMValues );
 	}
+	if(m_binaryOnHeap){
+		free( m_binaryValues );
+	}
 }
 
+void CShiftPWM::ReportError(unsigned char error, int value){
+	// Errors are counted and remembered, the program is not halted.
+	// Use GetLastError, GetErrorCount or SetErrorCallback to handle them, or PrintLastError to print them.
+	if(m_errorCounts[error]<0xFFFF){
+		m_errorCounts[error]++;
+	}
+	m_lastError = error;
+	m_lastErrorValue = value;
+	if(m_errorCallback!=0){
+		m_errorCallback(error, value);
+	}
+}
+
+#ifndef SHIFTPWM_RELEASE
 bool CShiftPWM::IsValidPin(int pin){
 	if(pin<m_amountOfOutputs){
 		return 1;
 	}
 	else{
+		ReportError(ShiftPWM_errorInvalidPin, pin);
+		return 0;
+	}
+}
+
+bool CShiftPWM::IsValidChannel(int channel){
+	if(channel<m_amountOfChannels){
+		return 1;
+	}
+	else{
+		ReportError(ShiftPWM_errorInvalidChannel, channel);
+		return 0;
+	}
+}
+
+bool CShiftPWM::IsValidBinaryOutput(int output){
+	if(output>=0 && output<m_binaryRegisters*8){
+		return 1;
+	}
+	else{
+		ReportError(ShiftPWM_errorInvalidPin, output);
+		return 0;
+	}
+}
+#endif
+
+void CShiftPWM::SetErrorCallback(void (*callback)(unsigned char error, int value)){
+	// The callback is called from the function that caused the error, so keep it short.
+	m_errorCallback = callback;
+}
+
+unsigned char CShiftPWM::GetLastError(void){
+	return m_lastError;
+}
+
+int CShiftPWM::GetLastErrorValue(void){
+	return m_lastErrorValue;
+}
+
+unsigned int CShiftPWM::GetErrorCount(unsigned char error){
+	if(error>=ShiftPWM_amountOfErrorTypes){
+		return 0;
+	}
+	return m_errorCounts[error];
+}
+
+void CShiftPWM::ClearErrors(void){
+	for(unsigned char k=0; k<ShiftPWM_amountOfErrorTypes; k++){
+		m_errorCounts[k]=0;
+	}
+	m_lastError = ShiftPWM_errorNone;
+	m_lastErrorValue = 0;
+}
+
+void CShiftPWM::PrintLastError(void){
+	// Not available with SHIFTPWM_RELEASE, to keep the error strings out of program memory.
+	#ifndef SHIFTPWM_RELEASE
+	switch(m_lastError){
+	case ShiftPWM_errorNone:
+		Serial.println(F("No error."));
+		break;
+	case ShiftPWM_errorInvalidPin:
 		Serial.print(F("Error: Trying to write duty cycle of pin "));
-		Serial.print(pin);
+		Serial.print(m_lastErrorValue);
 		Serial.print(F(" , while number of outputs is "));
 		Serial.print(m_amountOfOutputs);
 		Serial.print(F(" , numbered 0-"));
 		Serial.println(m_amountOfOutputs-1);
-		delay(1000);
-		return 0;
+		break;
+	case ShiftPWM_errorInvalidChannel:
+		Serial.print(F("Error: Trying to write duty cycle of channel "));
+		Serial.print(m_lastErrorValue);
+		Serial.print(F(" , while number of channels in the channel map is "));
+		Serial.print(m_amountOfChannels);
+		Serial.print(F(" , numbered 0-"));
+		Serial.println(m_amountOfChannels-1);
+		break;
+	case ShiftPWM_errorLoadTooHigh:
+		Serial.print(F("Error: Interrupt load would become too high with "));
+		Serial.print(m_lastErrorValue);
+		Serial.println(F(" registers."));
+		break;
+	case ShiftPWM_errorBufferTooSmall:
+		Serial.print(F("Error: Buffer is too small for "));
+		Serial.print(m_lastErrorValue);
+		Serial.println(F(" registers."));
+		break;
+	case ShiftPWM_errorOutOfMemory:
+		Serial.print(F("Error: Not enough memory for "));
+		Serial.print(m_lastErrorValue);
+		Serial.println(F(" registers."));
+		break;
+	case ShiftPWM_errorInvalidLatchPin:
+		Serial.print(F("Error: Latch pin "));
+		Serial.print(m_lastErrorValue);
+		Serial.print(F(" is not the OCnB or OCnC output of timer "));
+		Serial.println(m_timer);
+		break;
+	case ShiftPWM_errorInvalidOEPin:
+		Serial.print(F("Error: Output enable pin "));
+		Serial.print(m_lastErrorValue);
+		Serial.print(F(" is not a PWM pin, or its timer is the ShiftPWM timer "));
+		Serial.println(m_timer);
+		break;
+	case ShiftPWM_errorFrequencyTooLow:
+		Serial.print(F("Error: Timer"));
+		Serial.print(m_timer);
+		Serial.print(F(" cannot run as slow as "));
+		Serial.print(m_lastErrorValue);
+		Serial.println(F(" Hz with these brightness levels, even with the largest prescaler."));
+		break;
+	case ShiftPWM_errorInvalidClasses:
+		Serial.print(F("Error: Invalid register classes for "));
+		Serial.print(m_lastErrorValue);
+		Serial.println(F(" registers. Use only 'P' and 'B', at most 255 registers, and no matrix."));
+		break;
+	case ShiftPWM_errorFixedRegisters:
+		Serial.print(F("Error: Cannot change the registers or buffer of a fixed chain to "));
+		Serial.print(m_lastErrorValue);
+		Serial.println(F(" registers."));
+		break;
+	case ShiftPWM_errorInvalidBits:
+		Serial.print(F("Error: Bit angle modulation cannot use "));
+		Serial.print(m_lastErrorValue);
+		Serial.println(F(" bits. Use 1 to 8 bits."));
+		break;
 	}
+	Serial.print(F("Number of times this error occurred: "));
+	Serial.println(m_errorCounts[m_lastError]);
+	#endif
 }
 
-
 void CShiftPWM::SetOne(int pin, unsigned char value){
 	if(IsValidPin(pin) ){
-		m_PWMValues[pin]=value;
+		StoreValue(pin, value);
 	}
+	ValuesChanged();
 }
 
 void CShiftPWM::SetAll(unsigned char value){
 	for(int k=0 ; k<(m_amountOfOutputs);k++){
-		m_PWMValues[k]=value;
+		StoreValue(k, value);
 	}
+	ValuesChanged();
 }
 
 void CShiftPWM::SetGroupOf2(int group, unsigned char v0,unsigned char v1, int offset){
+	if(m_channelMap!=0){
+		int channel = group*2+offset;
+		if(IsValidChannel(channel+1) ){
+			unsigned int * map = &m_channelMap[channel];
+			StoreValue(map[0], v0);
+			StoreValue(map[1], v1);
+		}
+		ValuesChanged();
+		return;
+	}
 	int skip = m_pinGrouping*(group/m_pinGrouping); // is not equal to 2*group. Division is rounded down first.
 	if(IsValidPin(group+skip+offset+m_pinGrouping) ){
-		m_PWMValues[group+skip+offset]					=v0;
-		m_PWMValues[group+skip+offset+m_pinGrouping]	=v1;
+		StoreValue(group+skip+offset, v0);
+		StoreValue(group+skip+offset+m_pinGrouping, v1);
 	}
+	ValuesChanged();
 }
 
 void CShiftPWM::SetGroupOf3(int group, unsigned char v0,unsigned char v1,unsigned char v2, int offset){
+	if(m_channelMap!=0){
+		int channel = group*3+offset;
+		if(IsValidChannel(channel+2) ){
+			unsigned int * map = &m_channelMap[channel];
+			StoreValue(map[0], v0);
+			StoreValue(map[1], v1);
+			StoreValue(map[2], v2);
+		}
+		ValuesChanged();
+		return;
+	}
 	int skip = 2*m_pinGrouping*(group/m_pinGrouping); // is not equal to 2*group. Division is rounded down first.
 	if(IsValidPin(group+skip+offset+2*m_pinGrouping) ){
-		m_PWMValues[group+skip+offset]					=v0;
-		m_PWMValues[group+skip+offset+m_pinGrouping]	=v1;
-		m_PWMValues[group+skip+offset+m_pinGrouping*2]	=v2;
+		StoreValue(group+skip+offset, v0);
+		StoreValue(group+skip+offset+m_pinGrouping, v1);
+		StoreValue(group+skip+offset+m_pinGrouping*2, v2);
 	}
+	ValuesChanged();
 }
 
 void CShiftPWM::SetGroupOf4(int group, unsigned char v0,unsigned char v1,unsigned char v2,unsigned char v3, int offset){
+	if(m_channelMap!=0){
+		int channel = group*4+offset;
+		if(IsValidChannel(channel+3) ){
+			unsigned int * map = &m_channelMap[channel];
+			StoreValue(map[0], v0);
+			StoreValue(map[1], v1);
+			StoreValue(map[2], v2);
+			StoreValue(map[3], v3);
+		}
+		ValuesChanged();
+		return;
+	}
 	int skip = 3*m_pinGrouping*(group/m_pinGrouping); // is not equal to 2*group. Division is rounded down first.
 	if(IsValidPin(group+skip+offset+3*m_pinGrouping) ){
-		m_PWMValues[group+skip+offset]					=v0;
-		m_PWMValues[group+skip+offset+m_pinGrouping]	=v1;
-		m_PWMValues[group+skip+offset+m_pinGrouping*2]	=v2;
-		m_PWMValues[group+skip+offset+m_pinGrouping*3]	=v3;
+		StoreValue(group+skip+offset, v0);
+		StoreValue(group+skip+offset+m_pinGrouping, v1);
+		StoreValue(group+skip+offset+m_pinGrouping*2, v2);
+		StoreValue(group+skip+offset+m_pinGrouping*3, v3);
 	}
+	ValuesChanged();
 }
 
 void CShiftPWM::SetGroupOf5(int group, unsigned char v0,unsigned char v1,unsigned char v2,unsigned char v3,unsigned char v4, int offset){
+	if(m_channelMap!=0){
+		int channel = group*5+offset;
+		if(IsValidChannel(channel+4) ){
+			unsigned int * map = &m_channelMap[channel];
+			StoreValue(map[0], v0);
+			StoreValue(map[1], v1);
+			StoreValue(map[2], v2);
+			StoreValue(map[3], v3);
+			StoreValue(map[4], v4);
+		}
+		ValuesChanged();
+		return;
+	}
 	int skip = 4*m_pinGrouping*(group/m_pinGrouping); // is not equal to 2*group. Division is rounded down first.
 	if(IsValidPin(group+skip+offset+4*m_pinGrouping) ){
-		m_PWMValues[group+skip+offset]					=v0;
-		m_PWMValues[group+skip+offset+m_pinGrouping]	=v1;
-		m_PWMValues[group+skip+offset+m_pinGrouping*2]	=v2;
-		m_PWMValues[group+skip+offset+m_pinGrouping*3]	=v3;
-		m_PWMValues[group+skip+offset+m_pinGrouping*4]	=v4;
+		StoreValue(group+skip+offset, v0);
+		StoreValue(group+skip+offset+m_pinGrouping, v1);
+		StoreValue(group+skip+offset+m_pinGrouping*2, v2);
+		StoreValue(group+skip+offset+m_pinGrouping*3, v3);
+		StoreValue(group+skip+offset+m_pinGrouping*4, v4);
 	}
+	ValuesChanged();
 }
 
 void CShiftPWM::SetRGB(int led, unsigned char r,unsigned char g,unsigned char b, int offset){
+	if(m_channelMap!=0){
+		int channel = led*3+offset;
+		if(IsValidChannel(channel+2) ){
+			unsigned int * map = &m_channelMap[channel];
+			StoreValue(map[0], ( (unsigned int) r * m_maxBrightness)>>8);
+			StoreValue(map[1], ( (unsigned int) g * m_maxBrightness)>>8);
+			StoreValue(map[2], ( (unsigned int) b * m_maxBrightness)>>8);
+		}
+		ValuesChanged();
+		return;
+	}
 	int skip = 2*m_pinGrouping*(led/m_pinGrouping); // is not equal to 2*led. Division is rounded down first.
 	if(IsValidPin(led+skip+offset+2*m_pinGrouping) ){
-		m_PWMValues[led+skip+offset]					=( (unsigned int) r * m_maxBrightness)>>8;
-		m_PWMValues[led+skip+offset+m_pinGrouping]		=( (unsigned int) g * m_maxBrightness)>>8;
-		m_PWMValues[led+skip+offset+2*m_pinGrouping]	=( (unsigned int) b * m_maxBrightness)>>8;
+		StoreValue(led+skip+offset, ( (unsigned int) r * m_maxBrightness)>>8);
+		StoreValue(led+skip+offset+m_pinGrouping, ( (unsigned int) g * m_maxBrightness)>>8);
+		StoreValue(led+skip+offset+2*m_pinGrouping, ( (unsigned int) b * m_maxBrightness)>>8);
 	}
+	ValuesChanged();
 }
 
 void CShiftPWM::SetAllRGB(unsigned char r,unsigned char g,unsigned char b){
+	// Scale the values once, instead of for every LED
+	r = ( (unsigned int) r * m_maxBrightness)>>8;
+	g = ( (unsigned int) g * m_maxBrightness)>>8;
+	b = ( (unsigned int) b * m_maxBrightness)>>8;
+
+	if(m_channelMap!=0){
+		for(int k=0 ; k+2 < m_amountOfChannels; k+=3){
+			StoreValue(m_channelMap[k], r);
+			StoreValue(m_channelMap[k+1], g);
+			StoreValue(m_channelMap[k+2], b);
+		}
+		ValuesChanged();
+		return;
+	}
 	for(int k=0 ; (k+3*m_pinGrouping-1) < m_amountOfOutputs; k+=3*m_pinGrouping){
 		for(int l=0; l<m_pinGrouping;l++){
-			m_PWMValues[k+l]				=	( (unsigned int) r * m_maxBrightness)>>8;
-			m_PWMValues[k+l+m_pinGrouping]	=	( (unsigned int) g * m_maxBrightness)>>8;
-			m_PWMValues[k+l+m_pinGrouping*2]	=	( (unsigned int) b * m_maxBrightness)>>8;
+			StoreValue(k+l, r);
+			StoreValue(k+l+m_pinGrouping, g);
+			StoreValue(k+l+m_pinGrouping*2, b);
 		}
 	}
+	ValuesChanged();
 }
 
-void CShiftPWM::SetHSV(int led, unsigned int hue, unsigned int sat, unsigned int val, int offset){
-	unsigned char r,g,b;
+void CShiftPWM::HSVtoRGB(unsigned int hue, unsigned int sat, unsigned int val, unsigned char &r, unsigned char &g, unsigned char &b){
+	hue %= 360; // the hue wraps around: 360 is red again, like 0
 	unsigned int H_accent = hue/60;
 	unsigned int bottom = ((255 - sat) * val)>>8;
 	unsigned int top = val;
@@ -173,14 +481,690 @@ void CShiftPWM::SetHSV(int led, unsigned int hue, unsigned int sat, unsigned int
 		b = falling;
 		break;
 	}
+}
+
+void CShiftPWM::SetHSV(int led, unsigned int hue, unsigned int sat, unsigned int val, int offset){
+	unsigned char r,g,b;
+	HSVtoRGB(hue, sat, val, r, g, b);
 	SetRGB(led,r,g,b,offset);
 }
 
 void CShiftPWM::SetAllHSV(unsigned int hue, unsigned int sat, unsigned int val){
-	// Set the first LED
-	SetHSV(0, hue, sat, val);
-	// Copy RGB values all LED's.
-	SetAllRGB(m_PWMValues[0],m_PWMValues[m_pinGrouping],m_PWMValues[2*m_pinGrouping]);
+	unsigned char r,g,b;
+	HSVtoRGB(hue, sat, val, r, g, b);
+	SetAllRGB(r,g,b);
+}
+
+// The functions below change all values at once, in the order of the draw buffer: output 0 first, without pin grouping or
+// channel map. Like StoreValue, they write to the back buffer when double buffering (see CShiftPWMMatrix::SwapBuffers).
+// The buffers that are passed have one value per output (amount of registers * 8, times the amount of rows for a matrix).
+// They use one pointer walk and an 8 bit multiply per value, and update the sum of the values once at the end.
+
+void CShiftPWM::ScaleAll(unsigned char scale){
+	// Multiplies all values by (scale+1)/256: 255 keeps them, 127 halves them, 0 switches all outputs off.
+	unsigned char * value = DrawBuffer();
+	for(int k=m_amountOfOutputs; k>0; --k){
+		*value = ShiftPWM_scale8(*value, scale);
+		value++;
+	}
+	DrawBufferChanged();
+}
+
+void CShiftPWM::AddBuffer(const unsigned char * values){
+	// Adds values to the current values, up to maxBrightness.
+	unsigned char * value = DrawBuffer();
+	unsigned char maxValue = m_maxBrightness;
+	// New values are scaled while the current budget is exceeded, see SetCurrentBudget. SwapBuffers fits the back buffer in the budget.
+	unsigned char budgetScale = (m_backValues!=0) ? 255 : m_budgetScale-1;
+	for(int k=m_amountOfOutputs; k>0; --k){
+		unsigned char add = *values++;
+		if(budgetScale!=255){
+			add = ShiftPWM_scale8(add, budgetScale);
+		}
+		unsigned int sum = *value + add;
+		*value++ = (sum < maxValue) ? sum : maxValue;
+	}
+	DrawBufferChanged();
+}
+
+void CShiftPWM::BlendBuffers(const unsigned char * from, const unsigned char * to, unsigned char amount){
+	// Crossfades between two scenes: amount 0 shows from, 255 shows to.
+	unsigned char * value = DrawBuffer();
+	unsigned char budgetScale = (m_backValues!=0) ? 255 : m_budgetScale-1;
+	for(int k=m_amountOfOutputs; k>0; --k){
+		unsigned char a = *from++;
+		unsigned char b = *to++;
+		unsigned char blended;
+		if(b >= a){
+			blended = a + ShiftPWM_scale8(b-a, amount);
+		}
+		else{
+			blended = a - ShiftPWM_scale8(a-b, amount);
+		}
+		if(budgetScale!=255){
+			blended = ShiftPWM_scale8(blended, budgetScale);
+		}
+		*value++ = blended;
+	}
+	DrawBufferChanged();
+}
+
+void CShiftPWM::MaxBuffer(const unsigned char * values){
+	// Each output gets the highest of its current value and the new value. Useful to draw one scene on top of another.
+	unsigned char * value = DrawBuffer();
+	unsigned char budgetScale = (m_backValues!=0) ? 255 : m_budgetScale-1;
+	for(int k=m_amountOfOutputs; k>0; --k){
+		unsigned char other = *values++;
+		if(budgetScale!=255){
+			other = ShiftPWM_scale8(other, budgetScale);
+		}
+		if(other > *value){
+			*value = other;
+		}
+		value++;
+	}
+	DrawBufferChanged();
+}
+
+void CShiftPWM::MinBuffer(const unsigned char * values){
+	// Each output gets the lowest of its current value and the new value. Useful as a mask.
+	unsigned char * value = DrawBuffer();
+	unsigned char budgetScale = (m_backValues!=0) ? 255 : m_budgetScale-1;
+	for(int k=m_amountOfOutputs; k>0; --k){
+		unsigned char other = *values++;
+		if(budgetScale!=255){
+			other = ShiftPWM_scale8(other, budgetScale);
+		}
+		if(other < *value){
+			*value = other;
+		}
+		value++;
+	}
+	DrawBufferChanged();
+}
+
+void CShiftPWM::SetOutputEnablePin(int pin){
+	// The output enable pins (active low) of all shift registers are connected to a PWM pin of a timer that ShiftPWM does not use.
+	// The master brightness is then set with hardware PWM on this pin: it costs no CPU time and the values are not changed,
+	// so all brightness levels of the outputs are kept at every master brightness.
+	// This reprograms the prescaler of that timer, and the timer has to stay in the 8 bit PWM mode that the Arduino core sets.
+	// The other pins of the same timer run at the new frequency with analogWrite, and libraries that use the timer (Servo,
+	// tone) or change its waveform mode do not work together with the output enable pin.
+	#if defined(__AVR__)
+	m_oePin = pin;
+	int oeTimer = OutputEnableTimer();
+	if(oeTimer<0 || oeTimer==m_timer){
+		ReportError(ShiftPWM_errorInvalidOEPin, pin);
+		m_oePin = -1;
+		return;
+	}
+	pinMode(m_oePin, OUTPUT);
+	SetMasterBrightness(m_masterBrightness);
+
+	// The Arduino core sets up the timer in 8 bit PWM mode with a prescaler of 64. Remove the prescaler, so the OE frequency is far above the frequency
+	// of ShiftPWM and the two do not beat visibly. Timer0 is used for millis() and is left at its default (976 Hz).
+	if(oeTimer==1){
+		#if defined(SHIFTPWM_TINY_TIMER1)
+		TCCR1 = (TCCR1 & 0xF0) | _BV(CS10); // the clock select bits of the ATtiny85 timer1 are CS13:CS10
+		#else
+		bitSet(TCCR1B,CS10); bitClear(TCCR1B,CS11); bitClear(TCCR1B,CS12);
+		#endif
+	}
+	#if defined(OCR2A)
+	else if(oeTimer==2){
+		bitSet(TCCR2B,CS20); bitClear(TCCR2B,CS21); bitClear(TCCR2B,CS22);
+	}
+	#endif
+	#if defined(OCR3A)
+	else if(oeTimer==3){
+		bitSet(TCCR3B,CS30); bitClear(TCCR3B,CS31); bitClear(TCCR3B,CS32);
+	}
+	#endif
+	#if defined(TC4H)
+	else if(oeTimer==4){
+		TCCR4B = (TCCR4B & 0xF0) | _BV(CS40); // the clock select bits of the 32u4 timer4 are CS43:CS40
+	}
+	#elif defined(OCR4A)
+	else if(oeTimer==4){
+		bitSet(TCCR4B,CS40); bitClear(TCCR4B,CS41); bitClear(TCCR4B,CS42);
+	}
+	#endif
+	#if defined(OCR5A)
+	else if(oeTimer==5){
+		bitSet(TCCR5B,CS50); bitClear(TCCR5B,CS51); bitClear(TCCR5B,CS52);
+	}
+	#endif
+	#else
+	ReportError(ShiftPWM_errorInvalidOEPin, pin); // no hardware PWM for the output enable pin
+	#endif
+}
+
+void CShiftPWM::SetMasterBrightness(unsigned char brightness){
+	// 255 is full brightness, 0 is off. All outputs are scaled with brightness/255 by the hardware.
+	m_masterBrightness = brightness;
+	if(m_oePin<0){
+		return;
+	}
+	// OE is active low, so the pin is low for brightness/255 of the time.
+	// analogWrite only changes the compare register, or writes the pin for 0 and 255.
+	#if defined(__AVR__)
+	analogWrite(m_oePin, 255-brightness);
+	#endif
+}
+
+unsigned char CShiftPWM::GetMasterBrightness(void){
+	return m_masterBrightness;
+}
+
+#if defined(__AVR__)
+int CShiftPWM::OutputEnableTimer(void){
+	// Returns the number of the timer that can generate PWM on the output enable pin, or -1 if it is not a PWM pin.
+	switch(digitalPinToTimer(m_oePin)){
+	case TIMER0A:
+	case TIMER0B:
+		return 0;
+	case TIMER1A:
+	case TIMER1B:
+	#if defined(OCR1C) && !defined(SHIFTPWM_TINY_TIMER1)
+	case TIMER1C:
+	#endif
+		return 1;
+	#if defined(OCR2A)
+	case TIMER2A:
+	case TIMER2B:
+		return 2;
+	#endif
+	#if defined(OCR3A)
+	case TIMER3A:
+	case TIMER3B:
+	case TIMER3C:
+		return 3;
+	#endif
+	#if defined(OCR4A)
+	case TIMER4A:
+	case TIMER4B:
+	#if defined(TC4H)
+	case TIMER4D:
+	#else
+	case TIMER4C:
+	#endif
+		return 4;
+	#endif
+	#if defined(OCR5A)
+	case TIMER5A:
+	case TIMER5B:
+	case TIMER5C:
+		return 5;
+	#endif
+	default:
+		return -1;
+	}
+}
+#endif
+
+void CShiftPWM::SetCurrentBudget(unsigned int budget_mA, unsigned int outputCurrent_mA){
+	// Limits the average current of all outputs together to budget_mA. outputCurrent_mA is the current of one output that is always on.
+	// The sum of all values is kept up to date by the functions that set values, so checking the budget does not read all values.
+	// When a new value makes the total exceed the budget, all values are scaled down once to fit, and new values are scaled by the
+	// same factor. When the requested values fit again, they are restored. The colors stay the same, only dimmer.
+	// A budget of 0 switches the limiter off. outputCurrent_mA is also used by GetConsumedCharge.
+	m_currentBudget = budget_mA;
+	m_outputCurrent = outputCurrent_mA;
+	m_budgetScale = 256;
+	UpdateDutyLimit();
+	ValuesChanged();
+}
+
+void CShiftPWM::UpdateDutyLimit(void){
+	// Each output is on for value/StepsPerRow() of the time, and for a matrix only when its row is on.
+	if(m_currentBudget==0 || m_outputCurrent==0 || m_ledFrequency==0){
+		m_dutyLimit = 0; // no budget, or not started yet (maxBrightness is not known)
+		return;
+	}
+	unsigned long limit = ((unsigned long) m_currentBudget*StepsPerRow()*m_amountOfRows)/m_outputCurrent;
+	unsigned long maxSum = (unsigned long) m_amountOfOutputs*m_maxBrightness; // all outputs fully on
+	if(limit > maxSum){
+		limit = maxSum; // the budget is never exceeded, but keep the limiter enabled for when outputs are added
+	}
+	m_dutyLimit = (limit>=1) ? limit : 1;
+}
+
+void CShiftPWM::ApplyCurrentBudget(void){
+	if(m_dutySum > m_dutyLimit){
+		// Scale all values down, so they fit in the budget. All values are only read when the total crosses the budget.
+		unsigned int scale = (m_dutyLimit*256)/m_dutySum; // smaller than 256
+		if(scale==0){
+			scale = 1; // keep m_budgetScale above 0, it is divided by below
+		}
+		unsigned long sum = 0;
+		int partial = 0;
+		for(int k=0; k<m_amountOfOutputs; k++){
+			m_PWMValues[k] = ((unsigned int) m_PWMValues[k]*scale)>>8;
+			sum += m_PWMValues[k];
+			partial += IsPartialValue(m_PWMValues[k]);
+		}
+		m_budgetScale = ((unsigned long) m_budgetScale*scale)>>8;
+		if(m_budgetScale==0){
+			m_budgetScale = 1;
+		}
+		uint8_t oldSREG = SREG;
+		cli(); // the interrupt reads m_dutySum for the energy meter and m_partialOutputs for the idle shutdown
+		m_dutySum = sum;
+		m_partialOutputs = partial;
+		SREG = oldSREG;
+	}
+	else if(m_budgetScale!=256 && m_dutySum*256 <= m_dutyLimit*m_budgetScale){
+		// All values have been set with m_budgetScale since the last scaling. Without scaling they fit in the budget again,
+		// so restore them. Rounding down makes sure the sum stays below the limit.
+		unsigned long sum = 0;
+		int partial = 0;
+		for(int k=0; k<m_amountOfOutputs; k++){
+			unsigned int value = ((unsigned int) m_PWMValues[k]*256)/m_budgetScale;
+			m_PWMValues[k] = (value<255) ? value : 255;
+			sum += m_PWMValues[k];
+			partial += IsPartialValue(m_PWMValues[k]);
+		}
+		m_budgetScale = 256;
+		uint8_t oldSREG = SREG;
+		cli(); // the interrupt reads m_dutySum for the energy meter and m_partialOutputs for the idle shutdown
+		m_dutySum = sum;
+		m_partialOutputs = partial;
+		SREG = oldSREG;
+	}
+}
+
+void CShiftPWM::FitInCurrentBudget(unsigned char * values){
+	// The values of a frame that is not shown yet are the requested ones, not scaled with m_budgetScale. Scale the whole frame
+	// down if it does not fit, so it is never shown above the budget. Each frame is scaled on its own, so m_budgetScale
+	// starts at 256 again for the values set after it is shown.
+	m_budgetScale = 256;
+	if(m_dutyLimit==0){
+		return;
+	}
+	unsigned long sum = 0;
+	for(int k=0; k<m_amountOfOutputs; k++){
+		sum += values[k];
+	}
+	if(sum > m_dutyLimit){
+		unsigned int scale = (m_dutyLimit*256)/sum; // smaller than 256
+		for(int k=0; k<m_amountOfOutputs; k++){
+			values[k] = ((unsigned int) values[k]*scale)>>8;
+		}
+	}
+}
+
+unsigned int CShiftPWM::GetBudgetScale(void){
+	// 256 if the budget is not exceeded, otherwise new values are multiplied by GetBudgetScale()/256.
+	return m_budgetScale;
+}
+
+unsigned long CShiftPWM::GetDutySum(void){
+	return m_dutySum;
+}
+
+void CShiftPWM::RecalculateDutySum(void){
+	// Adds up all values. Only needed after writing m_PWMValues directly.
+	unsigned long sum = 0;
+	int partial = 0;
+	for(int k=0; k<m_amountOfOutputs; k++){
+		sum += m_PWMValues[k];
+		partial += IsPartialValue(m_PWMValues[k]);
+	}
+	uint8_t oldSREG = SREG;
+	cli(); // the interrupt reads m_dutySum for the energy meter and m_partialOutputs for the idle shutdown
+	m_dutySum = sum;
+	m_partialOutputs = partial;
+	SREG = oldSREG;
+	ValuesChanged();
+}
+
+// Converts m_dutyIntegral to microseconds. It counts the steps that outputs were on, at stepsPerSecond steps per second.
+// Integer math like the timer settings, so the energy meter does not pull in floating point. Dividing first keeps the
+// multiplication from overflowing when the integral is large.
+static unsigned long long ShiftPWM_stepsToMicros(unsigned long long steps, unsigned long stepsPerSecond){
+	return (steps/stepsPerSecond)*1000000 + ((steps%stepsPerSecond)*1000000)/stepsPerSecond;
+}
+
+unsigned long long CShiftPWM::OnTimeMicros(void){
+	uint8_t oldSREG = SREG;
+	cli(); // the interrupt changes m_dutyIntegral
+	unsigned long long integral = m_dutyIntegral;
+	if(m_idle){
+		integral += IdleDutyIntegral(); // the interrupt does not add the periods while it is stopped
+	}
+	unsigned long long onTime = m_onTimeMicros;
+	SREG = oldSREG;
+	if(m_governedFrequency==0){
+		return onTime;
+	}
+	return onTime + ShiftPWM_stepsToMicros(integral, (unsigned long) m_governedFrequency*StepsPerRow()*m_amountOfRows);
+}
+
+unsigned long CShiftPWM::GetOnTime(void){
+	// Returns the total time in milliseconds that outputs have been on since Start or ResetOnTime, added up over all outputs.
+	// For example, 10 outputs at half brightness for 60 seconds give 300000 ms. Multiply by the current of an output for the charge.
+	// The interrupt adds the sum of all values once per period, so this costs almost no time.
+	// The result wraps after 49 days of one output fully on, call ResetOnTime before that.
+	return OnTimeMicros()/1000;
+}
+
+unsigned long CShiftPWM::GetConsumedCharge(void){
+	// Returns the charge used by the outputs in uAh, with the output current set by SetCurrentBudget.
+	return (OnTimeMicros()*m_outputCurrent)/3600000;
+}
+
+void CShiftPWM::ResetOnTime(void){
+	uint8_t oldSREG = SREG;
+	cli(); // the interrupt changes m_dutyIntegral
+	m_dutyIntegral = 0;
+	m_onTimeMicros = 0;
+	if(m_idle){
+		m_frameCount += IdlePeriods(); // the frames while idle are counted from m_idleStart as well
+	}
+	m_idleStart = millis();
+	SREG = oldSREG;
+}
+
+void CShiftPWM::SetIdleShutdown(bool enable){
+	// When all values are 0 or maxBrightness (or higher), all periods of the PWM are the same. The interrupt then latches the
+	// outputs once and stops, so it uses no time until a value changes. The functions that set values start it again.
+	// Outputs at maxBrightness are fully on while the interrupt is stopped, instead of off for 1 of the maxBrightness+1 steps.
+	// The timer keeps running without its interrupt, so sleep modes that wake up on interrupts can be used while idle.
+	// Disabled by default, call SetIdleShutdown(true) in setup to use it. While the interrupt is stopped:
+	// - values written to m_PWMValues directly are not shown until you call RecalculateDutySum,
+	// - the frame callback is not called (GetFrameCount still counts the periods),
+	// - PrintInterruptLoad reports that the interrupt is idle instead of its load.
+	// Only the interrupt of a strip or chain stops, not the interrupt of a matrix.
+	m_idleShutdown = enable;
+	if(!enable && m_idle){
+		ResumeFromIdle();
+	}
+}
+
+bool CShiftPWM::IsIdle(void){
+	return m_idle;
+}
+
+void CShiftPWM::EnterIdle(void){
+	// Called by the interrupt after it has latched the first step of a period, when m_partialOutputs is 0.
+	DisableTimerInterrupt();
+	if(!m_idle){
+		m_idleStart = millis();
+		m_idleDutySum = m_dutySum;
+		m_idle = true;
+	}
+}
+
+void CShiftPWM::ResumeFromIdle(void){
+	uint8_t oldSREG = SREG;
+	cli(); // the interrupt reads m_idle
+	if(m_idle){
+		m_dutyIntegral += IdleDutyIntegral();
+		m_frameCount += IdlePeriods();
+		m_idle = false;
+		// The interrupt stopped at the start of a period, where it would have taken the new sizes and offset. It does not
+		// pass the end of a period before it latches, so they are taken here.
+		StartPeriod();
+		EnableTimerInterrupt(); // the compare flag is already set, so the interrupt runs right away and latches the new values
+	}
+	SREG = oldSREG;
+}
+
+unsigned long CShiftPWM::IdlePeriods(void){
+	// The periods since the interrupt stopped
+	return ((unsigned long long) (millis()-m_idleStart)*m_governedFrequency)/1000;
+}
+
+unsigned long long CShiftPWM::IdleDutyIntegral(void){
+	// What the interrupt would have added to m_dutyIntegral since it stopped, once per period.
+	return (unsigned long long) m_idleDutySum*IdlePeriods();
+}
+
+void CShiftPWM::SetLoadGovernor(int minFrequency, unsigned int maxLoopMicros){
+	// Lets the interrupt run at a lower PWM frequency while the program needs the time, down to minFrequency.
+	// Choose minFrequency above the frequency where you start to see flicker. The brightness of the outputs does not change.
+	// The demand comes from SetLoadDemand, and from UpdateLoadGovernor when maxLoopMicros is not 0: when a loop takes longer
+	// than maxLoopMicros, the frequency is lowered, and when the loops are short again, it slowly goes back to the frequency of Start.
+	// A minFrequency of 0 switches the governor off and restores the frequency of Start.
+	m_governorMinFrequency = (minFrequency < m_ledFrequency || m_ledFrequency==0) ? minFrequency : 0;
+	m_governorMaxLoopMicros = maxLoopMicros;
+	m_loopDemand = 0;
+	m_lastLoopMicros = micros();
+	if(m_governorMinFrequency==0){
+		m_userDemand = 0;
+		m_governorDemand = 0;
+		ApplyGovernedFrequency();
+	}
+}
+
+void CShiftPWM::SetLoadDemand(unsigned char demand){
+	// 0 runs at the frequency of Start, 255 at the minimum frequency of SetLoadGovernor.
+	// For example, set it to 255 before a long SD card read and back to 0 after. It takes effect in UpdateLoadGovernor.
+	m_userDemand = demand;
+}
+
+void CShiftPWM::UpdateLoadGovernor(void){
+	// Call this once in each loop. The frequency changes by at most 1/16 of the range per call, so it changes smoothly.
+	if(m_governorMinFrequency==0 || m_governedFrequency==0){
+		return;
+	}
+	if(m_governorMaxLoopMicros!=0){
+		unsigned long now = micros();
+		unsigned long loopTime = now-m_lastLoopMicros;
+		m_lastLoopMicros = now;
+		if(loopTime > m_governorMaxLoopMicros){
+			m_loopDemand = (m_loopDemand < 255-64) ? m_loopDemand+64 : 255; // react quickly when the program starves
+		}
+		else{
+			m_loopDemand = (m_loopDemand > 4) ? m_loopDemand-4 : 0; // and recover slowly, so the frequency does not oscillate
+		}
+	}
+	if(m_idle){
+		return; // the interrupt does not use any time, keep the frequency until it runs again
+	}
+	unsigned char target = (m_userDemand > m_loopDemand) ? m_userDemand : m_loopDemand;
+	if(target > m_governorDemand){
+		m_governorDemand = (target-m_governorDemand > 16) ? m_governorDemand+16 : target;
+	}
+	else if(target < m_governorDemand){
+		m_governorDemand = (m_governorDemand-target > 16) ? m_governorDemand-16 : target;
+	}
+	ApplyGovernedFrequency();
+}
+
+unsigned long CShiftPWM::GetFrameCount(void){
+	// The number of PWM periods (frames of a matrix) since Start. The interrupt counts them when it starts a new period,
+	// which is when new values are shown. While the interrupt is idle (see SetIdleShutdown), the count is calculated from millis().
+	uint8_t oldSREG = SREG;
+	cli(); // the interrupt changes m_frameCount
+	unsigned long count = m_frameCount;
+	if(m_idle){
+		count += IdlePeriods();
+	}
+	SREG = oldSREG;
+	return count;
+}
+
+bool CShiftPWM::FrameStarted(void){
+	// Returns true once for each new frame. Call it in loop and only update the values when it returns true:
+	// values that change more than once per frame are never shown.
+	unsigned long count = GetFrameCount();
+	if(count!=m_lastFrameSeen){
+		m_lastFrameSeen = count;
+		return true;
+	}
+	return false;
+}
+
+void CShiftPWM::WaitForFrame(void){
+	// Waits until the next frame starts. Returns right away if the interrupt does not run.
+	unsigned long start = GetFrameCount();
+	while(GetFrameCount()==start){
+		if(!m_idle && !TimerInterruptEnabled()){
+			break;
+		}
+	}
+	m_lastFrameSeen = GetFrameCount();
+}
+
+void CShiftPWM::SetFrameCallback(void (*callback)(void)){
+	// The callback is called by the interrupt at the start of each frame, with interrupts enabled. It has to be very short:
+	// it delays the next step of the PWM, and it must not take longer than one interrupt period or the interrupt nests.
+	// For longer work, use FrameStarted or WaitForFrame in loop. The callback is not called while the interrupt is idle.
+	uint8_t oldSREG = SREG;
+	cli(); // a function pointer is written in two instructions
+	m_frameCallback = callback;
+	SREG = oldSREG;
+}
+
+int CShiftPWM::GetGovernedFrequency(void){
+	// The PWM frequency the interrupt runs at now. Lower than the frequency of Start while the load governor lowers it.
+	return m_governedFrequency;
+}
+
+void CShiftPWM::ApplyGovernedFrequency(void){
+	if(m_governedFrequency==0){
+		return; // not started
+	}
+	int frequency = m_ledFrequency;
+	if(m_governorMinFrequency!=0){
+		frequency -= ((long) (m_ledFrequency-m_governorMinFrequency)*m_governorDemand)/255;
+	}
+	if(frequency==m_governedFrequency){
+		return;
+	}
+	unsigned long stepsPerSecond = (unsigned long) m_governedFrequency*StepsPerRow()*m_amountOfRows;
+	uint8_t oldSREG = SREG;
+	cli(); // the interrupt changes m_dutyIntegral
+	unsigned long long integral = m_dutyIntegral;
+	m_dutyIntegral = 0;
+	m_governedFrequency = frequency;
+	SREG = oldSREG;
+	// The periods so far were at the old frequency, convert them to microseconds for GetOnTime
+	m_onTimeMicros += ShiftPWM_stepsToMicros(integral, stepsPerSecond);
+	#if defined(__AVR__)
+	if(m_bamBits){
+		// The matrix interrupt sets the compare value for each bit. The new length is used from the next row on.
+		unsigned int longest = (CalculateCompareValue(frequency)+1) << (m_bamBits-1);
+		oldSREG = SREG;
+		cli();
+		m_bamLongest = longest;
+		SREG = oldSREG;
+	}
+	else{
+		SetTimerCompareValue(CalculateCompareValue(frequency));
+	}
+	#endif
+}
+
+void CShiftPWM::SetOffset(int offset){
+	// Shifts all outputs: output k shows the value of output k+offset, and the last outputs show the first values.
+	// Scrolling or rotating a strip only needs a new offset, the values are not copied. The new offset is used from the next period.
+	// Only works with '#define SHIFTPWM_VIEWPORT' before '#include <ShiftPWM.h>', or viewport set to true for a CShiftPWMChain.
+	if(m_amountOfOutputs==0){
+		return;
+	}
+	offset = offset % m_amountOfOutputs;
+	if(offset<0){
+		offset += m_amountOfOutputs;
+	}
+	m_viewStart = offset; // 0 is read as the end of the buffer
+	if(m_idle){
+		ResumeFromIdle(); // the interrupt latches the outputs at their new position
+	}
+}
+
+// The functions below set the outputs of the binary registers, see SetRegisterClasses. Binary output n is output n%8 of
+// binary register n/8. The binary registers are counted on their own, in the order of the chain.
+// The interrupt sends the byte of a binary register as it is, so it is stored in the bit order of the bytes that
+// ShiftPWM_registerByte calculates: output k is bit 7-k, or bit k on an ATtiny, where the USI sends bit 7 first.
+static inline unsigned char ShiftPWM_binaryBit(unsigned char output){
+	#if defined(USIDR) && !defined(SPDR)
+	return 1<<output;
+	#else
+	return 0x80>>output;
+	#endif
+}
+
+void CShiftPWM::SetBinaryOutput(int output, bool on){
+	if(IsValidBinaryOutput(output) ){
+		unsigned char * outputs = &m_binaryValues[output>>3];
+		uint8_t oldSREG = SREG;
+		cli(); // a read-modify-write, which the other bits should survive if the interrupt calls a function that sets them
+		if(on){
+			*outputs |= ShiftPWM_binaryBit(output&7);
+		}
+		else{
+			*outputs &= ~ShiftPWM_binaryBit(output&7);
+		}
+		SREG = oldSREG;
+	}
+	ValuesChanged();
+}
+
+void CShiftPWM::SetBinaryRegister(unsigned char binaryRegister, unsigned char outputs){
+	// Sets all 8 outputs of a binary register at once: bit k of outputs is output k of the register.
+	if(IsValidBinaryOutput(binaryRegister*8) ){
+		unsigned char stored = 0;
+		for(unsigned char k=0; k<8; k++){
+			if(outputs & (1<<k)){
+				stored |= ShiftPWM_binaryBit(k);
+			}
+		}
+		m_binaryValues[binaryRegister] = stored;
+	}
+	ValuesChanged();
+}
+
+void CShiftPWM::SetAllBinary(bool on){
+	for(unsigned char k=0; k<m_binaryRegisters; k++){
+		m_binaryValues[k] = on ? 0xFF : 0x00;
+	}
+	ValuesChanged();
+}
+
+bool CShiftPWM::GetBinaryOutput(int output){
+	if(!IsValidBinaryOutput(output) ){
+		return false;
+	}
+	return m_binaryValues[output>>3] & ShiftPWM_binaryBit(output&7);
+}
+
+const unsigned char * CShiftPWM::DecodeFrame_P(const unsigned char * frame){
+	// Decodes one frame of an animation in program memory and returns the start of the next frame.
+	// The format is described in CShiftPWMAnimation.h. Only the values that change are read and written.
+	int index = 0;
+	while(1){
+		unsigned char command = pgm_read_byte(frame++);
+		if(command==0){
+			break; // end of the frame, the other values do not change
+		}
+		if(command < 0x80){
+			index += command; // skip values that do not change
+			continue;
+		}
+		unsigned char count = (command & 0x3F)+1;
+		if(command & 0x40){
+			// count times the same value
+			unsigned char value = pgm_read_byte(frame++);
+			for(; count>0; --count, ++index){
+				if(index < m_amountOfOutputs){
+					StoreValue(index, value);
+				}
+			}
+		}
+		else{
+			// count different values
+			for(; count>0; --count, ++index){
+				unsigned char value = pgm_read_byte(frame++);
+				if(index < m_amountOfOutputs){
+					StoreValue(index, value);
+				}
+			}
+		}
+	}
+	ValuesChanged();
+	return frame;
 }
 
 // OneByOne functions are usefull for testing all your outputs
@@ -197,76 +1181,358 @@ void CShiftPWM::OneByOne_core(int delaytime){
 	SetAll(0);
 	for(int pin=0;pin<m_amountOfOutputs;pin++){
 		for(brightness=0;brightness<m_maxBrightness;brightness++){
-			m_PWMValues[pin]=brightness;
+			StoreValue(pin, brightness);
+			ValuesChanged();
 			delay(delaytime);
 		}
 		for(brightness=m_maxBrightness;brightness>=0;brightness--){
-			m_PWMValues[pin]=brightness;
+			StoreValue(pin, brightness);
+			ValuesChanged();
 			delay(delaytime);
 		}
 	}
 }
 
-void CShiftPWM::SetAmountOfRegisters(unsigned char newAmount){
-	cli(); // Disable interrupt
-	unsigned char oldAmount = m_amountOfRegisters;
-	m_amountOfRegisters = newAmount;
-	m_amountOfOutputs=m_amountOfRegisters*8;
-
-	if(LoadNotTooHigh() ){ //Check if new amount will not result in deadlock
-		m_PWMValues = (unsigned char *) realloc(m_PWMValues, newAmount*8); //resize array for PWMValues
+void CShiftPWM::SetAmountOfRegisters(unsigned char newAmount){
+	// For a matrix, this is the amount of column registers. All registers are PWM registers again, see SetRegisterClasses.
+	uint8_t oldSREG = SREG;
+	cli(); // the interrupt continues with the PWM registers that it was sending, until the end of the period
+	m_registerClasses = 0;
+	m_binaryRegisters = 0;
+	SREG = oldSREG;
+	Resize(m_amountOfRows, newAmount);
+}
+
+void CShiftPWM::Resize(unsigned char newRows, unsigned char newAmount){
+	// The interrupt keeps using the old amount until the end of the current PWM period (see ShiftPWM_core.h).
+	// Interrupts are only disabled for the few instructions that change the pointer and the amount.
+	int oldOutputs = m_amountOfOutputs;
+	int newOutputs = newRows*newAmount*8;
+	unsigned int newRegisters = newRows*newAmount;
+	uint8_t oldSREG;
+
+	if(m_fixedRegisters && (newRows!=m_amountOfRows || newAmount!=m_amountOfRegisters)){
+		ReportError(ShiftPWM_errorFixedRegisters, newAmount);
+		return;
+	}
+	if(!LoadNotTooHigh(newAmount, newRows, m_binaryRegisters) ){ //Check if new amount will not result in deadlock
+		// New value would result in deadlock, keep old values and report an error
+		ReportError(ShiftPWM_errorLoadTooHigh, newAmount);
+		return;
+	}
+
+	if(newRegisters > m_maxRegisters){
+		if(m_PWMValues!=0 && !m_bufferOnHeap){
+			// The buffer is set by the user and has a fixed size.
+			ReportError(ShiftPWM_errorBufferTooSmall, newAmount);
+			return;
+		}
+		// Allocate a larger buffer on the heap. This is done with interrupts enabled, the old buffer stays in use until it is replaced.
+		// The buffer only grows, it is kept when the amount is decreased. Use SetBuffer to avoid the heap completely.
+		unsigned char * newValues = (unsigned char *) malloc(newOutputs);
+		if(newValues==0){
+			ReportError(ShiftPWM_errorOutOfMemory, newAmount);
+			return;
+		}
+		for(int k=0; k<oldOutputs; k++){
+			newValues[k]=m_PWMValues[k]; //keep old values
+		}
+		unsigned char * oldValues = m_PWMValues;
+		oldSREG = SREG;
+		cli(); // Disable interrupt
+		m_PWMValues = newValues;
+		SREG = oldSREG; //Re-enable interrupt
+		if(m_bufferOnHeap){
+			free(oldValues);
+		}
+		m_bufferOnHeap = true;
+		m_maxRegisters = newRegisters;
+	}
+
+	for(int k=oldOutputs; k<newOutputs;k++){
+		m_PWMValues[k]=0; //set new values to zero
+	}
+
+	oldSREG = SREG;
+	cli(); // Disable interrupt
+	m_amountOfRows = newRows;
+	m_amountOfRegisters = newAmount;
+	m_amountOfOutputs = newOutputs;
+	SREG = oldSREG; //Re-enable interrupt
+
+	ValidateChannelMap();
+	// Values that are not used anymore do not count for the current budget, and the limit depends on the amount of rows.
+	UpdateDutyLimit();
+	RecalculateDutySum();
+}
+
+void CShiftPWM::SetBuffer(unsigned char * buffer, unsigned int maxRegisters){
+	// Use a static or user allocated buffer of maxRegisters*8 bytes for the PWM values, instead of the heap.
+	// After this, SetAmountOfRegisters can change the amount of registers up to maxRegisters without any heap operations.
+	// For a matrix, maxRegisters is the total of all rows: rows*column registers.
+	if(m_fixedRegisters){
+		ReportError(ShiftPWM_errorFixedRegisters, maxRegisters);
+		return;
+	}
+	if(maxRegisters < (unsigned int) m_amountOfRows*m_amountOfRegisters){
+		// Buffer is not changed, because it is smaller than the amount of registers
+		ReportError(ShiftPWM_errorBufferTooSmall, m_amountOfRegisters);
+		return;
+	}
+	for(int k=0; k<m_amountOfOutputs; k++){
+		buffer[k]=m_PWMValues[k]; //keep old values
+	}
+	unsigned char * oldValues = m_PWMValues;
+	uint8_t oldSREG = SREG;
+	cli(); // Disable interrupt
+	m_PWMValues = buffer;
+	m_activeRegisters = m_amountOfRegisters; // the interrupt should not read past the end of the new buffer
+	m_activeOutputs = m_amountOfOutputs;
+	m_activeRows = m_amountOfRows;
+	m_currentRow = 0;
+	m_rowStart = 0;
+	m_activeStart = 0; // the viewport is applied again at the start of the next period
+	SREG = oldSREG; //Re-enable interrupt
+	if(m_bufferOnHeap){
+		free(oldValues);
+	}
+	m_bufferOnHeap = false;
+	m_maxRegisters = maxRegisters;
+}
+
+void CShiftPWM::SetRegisterClasses(const char * classes, unsigned char * binaryBuffer){
+	// Sets the resolution of each register of the chain, with one letter per register, starting at the first register:
+	// 'P' for a PWM register, 'B' for a binary register. For example "PPBP": registers 0, 1 and 3 are PWM registers and
+	// register 2 drives relays or indicator leds that are only on or off. This also sets the length of the chain.
+	// A binary register needs one byte of RAM instead of 8 and its byte is sent as it is, without comparing 8 values.
+	// The PWM outputs are numbered over the PWM registers only, so SetOne(8) is output 0 of register 3 in the example.
+	// The binary outputs are set with SetBinaryOutput, SetBinaryRegister and SetAllBinary, and start off.
+	// binaryBuffer is one byte per 'B' to keep the binary outputs off the heap, like SetBuffer. classes is not copied,
+	// so it has to stay valid: use a string literal. SetAmountOfRegisters makes all registers PWM registers again.
+	// Not for a matrix, a fixed chain or with the viewport (SetOffset): their interrupts send only PWM registers.
+	unsigned int length = strlen(classes);
+	unsigned char pwmRegisters = 0;
+	unsigned char binaryRegisters = 0;
+	for(unsigned int k=0; k<length; k++){
+		if(classes[k]=='P') pwmRegisters++;
+		else if(classes[k]=='B') binaryRegisters++;
+	}
+	if(m_fixedRegisters){
+		ReportError(ShiftPWM_errorFixedRegisters, length);
+		return;
+	}
+	if(length>255 || pwmRegisters+binaryRegisters!=length || m_amountOfRows>1){
+		ReportError(ShiftPWM_errorInvalidClasses, length);
+		return;
+	}
+	if(!LoadNotTooHigh(pwmRegisters, m_amountOfRows, binaryRegisters) ){
+		ReportError(ShiftPWM_errorLoadTooHigh, length);
+		return;
+	}
+
+	unsigned char * newBinary = binaryBuffer;
+	if(newBinary==0){
+		newBinary = m_binaryValues;
+		if(binaryRegisters > m_maxBinaryRegisters || !m_binaryOnHeap){
+			newBinary = (unsigned char *) malloc(binaryRegisters>0 ? binaryRegisters : 1);
+			if(newBinary==0){
+				ReportError(ShiftPWM_errorOutOfMemory, length);
+				return;
+			}
+		}
+	}
+
+	// The interrupt sends the old PWM registers until the values are resized, then the new classes from the next interrupt.
+	const char * oldClasses = m_registerClasses;
+	unsigned char oldBinaryRegisters = m_binaryRegisters;
+	uint8_t oldSREG = SREG;
+	cli();
+	m_registerClasses = 0;
+	m_binaryRegisters = 0;
+	SREG = oldSREG;
+	Resize(1, pwmRegisters);
+	if(m_amountOfRegisters!=pwmRegisters){
+		// Resize reported the error and kept the old registers, so the old classes are valid again.
+		oldSREG = SREG;
+		cli();
+		m_registerClasses = oldClasses;
+		m_binaryRegisters = oldBinaryRegisters;
+		SREG = oldSREG;
+		if(newBinary!=binaryBuffer && newBinary!=m_binaryValues){
+			free(newBinary);
+		}
+		return;
+	}
+	for(unsigned char k=0; k<binaryRegisters; k++){
+		newBinary[k] = 0;
+	}
+
+	unsigned char * oldBinary = m_binaryValues;
+	oldSREG = SREG;
+	cli();
+	m_binaryValues = newBinary;
+	m_binaryRegisters = binaryRegisters;
+	m_registerClasses = (binaryRegisters>0) ? classes : 0;
+	m_activeRegisters = m_amountOfRegisters; // the classes have to match the PWM registers that the interrupt sends
+	m_activeOutputs = m_amountOfOutputs;
+	SREG = oldSREG;
+	if(oldBinary!=newBinary){
+		if(m_binaryOnHeap){
+			free(oldBinary);
+		}
+		m_binaryOnHeap = (binaryBuffer==0);
+		m_maxBinaryRegisters = binaryRegisters;
+	}
+	ValuesChanged();
+}
+
+void CShiftPWM::SetPinGrouping(int grouping){
+	// Sets the number of pins per color that are used after eachother. RRRRGGGGBBBBRRRRGGGGBBBB would be a grouping of 4.
+	m_pinGrouping = grouping;
+}
+
+void CShiftPWM::SetChannelMap(unsigned int * map, int amountOfChannels){
+	// Use a table that gives the output number for each channel. Channel numbers are used by SetGroupOfX, SetRGB and SetHSV:
+	// the channels of group (or led) n are n*X to n*X+X-1. Use SetChannelMap(0,0) to go back to SetPinGrouping.
+	m_channelMap = map;
+	m_channelMapLength = (map!=0) ? amountOfChannels : 0;
+	ValidateChannelMap();
+}
+
+void CShiftPWM::ValidateChannelMap(void){
+	// The setters only check the channel number, so the map is checked once here: only the channels before the first one
+	// with an output that does not exist can be used. Called again when the amount of outputs changes, a larger amount
+	// makes the channels usable again.
+	int channel = 0;
+	while(channel<m_channelMapLength && m_channelMap[channel]<(unsigned int) m_amountOfOutputs){
+		channel++;
+	}
+	m_amountOfChannels = channel;
+	if(channel<m_channelMapLength){
+		ReportError(ShiftPWM_errorInvalidChannel, channel);
+	}
+}
+
+int CShiftPWM::BuildChannelMap(unsigned int * map, int maxChannels, unsigned char colorsPerLed, int pinGrouping,
+                               const char * colorOrder, unsigned char skippedOutputs, int ledsPerRow){
+	// Fills map with the output of each channel and starts using it. Returns the number of channels in the map.
+	// colorsPerLed:   number of outputs per LED (or group), 3 for RGB
+	// pinGrouping:    same as SetPinGrouping, RRRGGGBBB is 3
+	// colorOrder:     order of the colors on the outputs, for example "GRB". Colors are numbered in the order R,G,B,W. 0 is RGBW order.
+	// skippedOutputs: bitmask of the outputs of each register that are not connected. 0x80 skips output 7 of every register.
+	// ledsPerRow:     if not 0, every other row of ledsPerRow LED's is wired in reverse (serpentine).
+	// Call this function after SetAmountOfRegisters. The map is only calculated once, so the setters only need a table lookup.
+
+	unsigned char usedBits[8]; // the outputs of a register that are connected
+	unsigned char usedPerRegister=0;
+	for(unsigned char bit=0; bit<8; bit++){
+		if(!(skippedOutputs & (1<<bit))){
+			usedBits[usedPerRegister++]=bit;
+		}
+	}
 
-		for(int k=oldAmount; k<(newAmount*8);k++){
-			m_PWMValues[k]=0; //set new values to zero
+	unsigned char colorPosition[4] = {0,1,2,3}; // position of each color within an LED
+	if(colorOrder!=0){
+		const char colorNames[] = "RGBW";
+		for(unsigned char position=0; position<colorsPerLed && colorOrder[position]!=0; position++){
+			for(unsigned char color=0; color<4; color++){
+				if(colorOrder[position]==colorNames[color]){
+					colorPosition[color]=position;
+				}
+			}
 		}
-		sei(); //Re-enable interrupt
 	}
-	else{
-		// New value would result in deadlock, keep old values and print an error message
-		m_amountOfRegisters = oldAmount;
-		m_amountOfOutputs=m_amountOfRegisters*8;
-		Serial.println(F("Amount of registers is not increased, because load would become too high"));
-		sei();
+
+	int channel;
+	for(channel=0; channel<maxChannels && usedPerRegister>0 && colorsPerLed>0; channel++){
+		int led = channel/colorsPerLed;
+		unsigned char color = channel%colorsPerLed;
+		if(ledsPerRow>0 && ((led/ledsPerRow)&1)){
+			led = (led/ledsPerRow)*ledsPerRow + ledsPerRow-1-led%ledsPerRow; // reversed row
+		}
+		int slot = (led/pinGrouping)*pinGrouping*colorsPerLed + colorPosition[color]*pinGrouping + led%pinGrouping;
+		int output = (slot/usedPerRegister)*8 + usedBits[slot%usedPerRegister];
+		if(output>=m_amountOfOutputs){
+			break; // not enough outputs for this channel
+		}
+		map[channel]=output;
 	}
+	SetChannelMap(map, channel);
+	return channel;
 }
 
-void CShiftPWM::SetPinGrouping(int grouping){
-	// Sets the number of pins per color that are used after eachother. RRRRGGGGBBBBRRRRGGGGBBBB would be a grouping of 4.
-	m_pinGrouping = grouping;
+unsigned int CShiftPWM::StepsPerRow(void){
+	// With PWM, each row (a strip is one row) gets maxBrightness+1 steps per period, and an output is on for value steps.
+	// With bit angle modulation, bit n is shown for 2^n steps, so a row takes maxBrightness steps.
+	return m_bamBits ? m_maxBrightness : m_maxBrightness+1;
+}
+
+unsigned long CShiftPWM::InterruptFrequency(unsigned char amountOfRows){
+	// With PWM, there is one interrupt per step. With bit angle modulation, this is the rate of the shortest interrupt period.
+	return (unsigned long) m_ledFrequency*StepsPerRow()*amountOfRows;
 }
 
-bool CShiftPWM::LoadNotTooHigh(void){
-	// This function calculates if the interrupt load would become higher than 0.9 and prints an error if it would.
-	// This is with inverted outputs, which is worst case. Without inverting, it would be 42 per register.
-	float interruptDuration;
-	if(m_noSPI){
-		interruptDuration = 96+108*(float) m_amountOfRegisters;
+unsigned int CShiftPWM::CalculateCompareValue(int ledFrequency){
+	// Compare value for the prescaler that Start selected, limited to the size of the timer. See ShiftPWM_timer.h.
+	// With bit angle modulation, this is the shortest bit, and the longest bit has to fit in the timer as well.
+	unsigned long compareValue = ShiftPWM_timerCompare(m_timerClock, (unsigned long) ledFrequency*StepsPerRow()*m_amountOfRows, m_prescaler);
+	unsigned long maxCompare = ShiftPWM_timerMaxCompare(m_timer);
+	if(m_bamBits){
+		maxCompare = (maxCompare >> (m_bamBits-1)) - 1; // see ShiftPWM_bamClockSelect
 	}
-	else{
-		interruptDuration = 97+43* (float) m_amountOfRegisters;
+	if(compareValue > maxCompare){
+		compareValue = maxCompare;
 	}
-	float interruptFrequency = (float) m_ledFrequency* ((float) m_maxBrightness + 1);
-	float load = interruptDuration*interruptFrequency/F_CPU;
+	return compareValue;
+}
 
-	if(load > 0.9){
+#if defined(__AVR__)
+bool CShiftPWM::LoadNotTooHigh(unsigned char amountOfRegisters, unsigned char amountOfRows, unsigned char binaryRegisters){
+	// This function calculates if the interrupt load would become higher than 0.9 and prints the details if it would.
+	// The estimate of the interrupt duration is in ShiftPWM_timer.h.
+	// With bit angle modulation, the interrupt has to fit in the shortest bit.
+	unsigned long interruptDuration = m_bamBits ? ShiftPWM_bamInterruptCycles(m_noSPI, amountOfRegisters) :
+	                                              ShiftPWM_interruptCycles(m_noSPI, amountOfRegisters, binaryRegisters);
+	unsigned long interruptFrequency = InterruptFrequency(amountOfRows);
+	if(!ShiftPWM_loadNotTooHigh(interruptDuration, interruptFrequency, F_CPU)){
+		#ifndef SHIFTPWM_RELEASE
 		Serial.print(F("New interrupt duration =")); Serial.print(interruptDuration); Serial.println(F("clock cycles"));
 		Serial.print(F("New interrupt frequency =")); Serial.print(interruptFrequency); Serial.println(F("Hz"));
-		Serial.print(F("New interrupt load would be "));
-		Serial.print(load);
-		Serial.println(F(" , which is too high."));
+		Serial.print(F("New interrupt load would be higher than 0.9: at most "));
+		Serial.print((F_CPU/10*9)/interruptFrequency);
+		Serial.println(F(" clock cycles are available per interrupt."));
+		#endif
 		return 0;
 	}
-	else{
-		return 1;
-	}
-
+	return 1;
+}
+#else
+bool CShiftPWM::LoadNotTooHigh(unsigned char, unsigned char, unsigned char){
+	return 1; // on other platforms, the interrupt is a thread, see linux/CShiftPWMLinux.h
 }
+#endif
 
 void CShiftPWM::Start(int ledFrequency, unsigned char maxBrightness){
+	m_bamBits = 0;
+	StartTimer(ledFrequency, maxBrightness);
+}
+
+void CShiftPWM::StartBAM(int ledFrequency, unsigned char bits){
+	// Bit angle modulation for CShiftPWMMatrix::StartBAM. The values have bits bits, so maxBrightness is 2^bits-1.
+	if(bits<1 || bits>8){
+		ReportError(ShiftPWM_errorInvalidBits, bits);
+		return;
+	}
+	m_bamBits = bits;
+	StartTimer(ledFrequency, (1<<bits)-1);
+}
+
+void CShiftPWM::StartTimer(int ledFrequency, unsigned char maxBrightness){
 	// Configure and enable timer1 or timer 2 for a compare and match A interrupt.
 	m_ledFrequency = ledFrequency;
 	m_maxBrightness = maxBrightness;
 
+	#if defined(__AVR__)
 	pinMode(m_dataPin, OUTPUT);
 	pinMode(m_clockPin, OUTPUT);
 	pinMode(m_latchPin, OUTPUT);
@@ -275,6 +1541,7 @@ void CShiftPWM::Start(int ledFrequency, unsigned char maxBrightness){
 	digitalWrite(m_dataPin, LOW);
 
 	if(!m_noSPI){ // initialize SPI when used
+		#if defined(SPCR)
 		// The least significant bit shoult be sent out by the SPI port first.
 		// equals SPI.setBitOrder(LSBFIRST);
 		SPCR |= _BV(DORD);
@@ -301,29 +1568,109 @@ void CShiftPWM::Start(int ledFrequency, unsigned char maxBrightness){
 		// the SS pin MUST be kept as OUTPUT.
 		SPCR |= _BV(MSTR);
 		SPCR |= _BV(SPE);
+		#elif defined(USICR)
+		// The ATtiny has a USI instead. Three-wire mode, clocked by software: the interrupt strobes USITC and USICLK
+		// (see ShiftPWM_spiWrite in ShiftPWM_core.h). The pins are DO and USCK, which are set as outputs above.
+		// The USI sends the most significant bit first, so the interrupt mirrors the bytes.
+		USICR = _BV(USIWM0);
+		#endif
+	}
+	#endif
+
+	// The interrupt starts with the current amount of registers
+	m_activeRegisters = m_amountOfRegisters;
+	m_activeOutputs = m_amountOfOutputs;
+	m_activeRows = m_amountOfRows;
+	m_currentRow = 0;
+	m_rowStart = 0;
+	m_activeStart = m_viewStart;
+	m_counter = 0;
+
+	m_idle = false; // the timer is initialized with its interrupt enabled
+	m_governedFrequency = ledFrequency; // the timer starts at full frequency
+	m_governorDemand = 0;
+	UpdateDutyLimit(); // depends on maxBrightness
+	RecalculateDutySum(); // which values are partially on depends on maxBrightness
+
+	if(m_hardwareLatch && HardwareLatchChannel()==0){
+		// The latch pin is not connected to the timer, so the timer cannot generate the latch pulse.
+		ReportError(ShiftPWM_errorInvalidLatchPin, m_latchPin);
+		return;
+	}
+
+	#if defined(__AVR__)
+	// The smallest prescaler for which the compare value fits in the timer, see ShiftPWM_timer.h
+	unsigned char clockSelect = m_bamBits ? ShiftPWM_bamClockSelect(m_timer, m_timerClock, InterruptFrequency(m_amountOfRows), m_bamBits) :
+	                                        ShiftPWM_timerClockSelect(m_timer, m_timerClock, InterruptFrequency(m_amountOfRows));
+	if(clockSelect==0){
+		ReportError(ShiftPWM_errorFrequencyTooLow, ledFrequency);
+		return;
+	}
+	m_prescaler = ShiftPWM_timerPrescaler(m_timer, clockSelect);
+	if(m_bamBits){
+		// The timer starts with the shortest bit, after that the interrupt sets the compare value for each bit
+		m_bamLongest = (CalculateCompareValue(ledFrequency)+1) << (m_bamBits-1);
+		m_bamTicks = m_bamLongest;
+		m_bamMask = (maxBrightness>>1)+1;
 	}
+	#endif
 
-	if(LoadNotTooHigh() ){
+	if(LoadNotTooHigh(m_amountOfRegisters, m_amountOfRows, m_binaryRegisters) ){
+		#if defined(__AVR__)
 		if(m_timer==1){
-			InitTimer1();
+			InitTimer1(clockSelect);
 		}
-		#if defined(USBCON)
+		#if defined(OCR2A)
+		else if(m_timer==2){
+			InitTimer2(clockSelect);
+		}
+		#endif
+		#if defined(OCR3A)
 		else if(m_timer==3){
-			InitTimer3();
+			InitTimer3(clockSelect);
+		}
+		#endif
+		#if defined(OCR4A)
+		else if(m_timer==4){
+			InitTimer4(clockSelect);
+		}
+		#endif
+		#if defined(OCR5A)
+		else if(m_timer==5){
+			InitTimer5(clockSelect);
+		}
+		#endif
+		if(m_hardwareLatch){
+			InitHardwareLatch();
 		}
 		#else
-			else if(m_timer==2){
-				InitTimer2();
-			}
+		EnableTimerInterrupt(); // there are no timers, a thread of the backend sends the periods (see linux/CShiftPWMLinux.h)
 		#endif
 	}
 	else{
+		ReportError(ShiftPWM_errorLoadTooHigh, m_amountOfRegisters);
+		#ifndef SHIFTPWM_RELEASE
 		Serial.println(F("Interrupts are disabled because load is too high."));
+		#endif
 		cli(); //Disable interrupts
 	}
 }
 
-void CShiftPWM::InitTimer1(void){
+#if defined(__AVR__)
+#if defined(SHIFTPWM_TINY_TIMER1)
+void CShiftPWM::InitTimer1(unsigned char clockSelect){
+	/* Timer1 of the ATtiny25/45/85 is an 8 bit timer. With CTC1 set, it is cleared on a compare match with OCR1C.
+	* The interrupt is generated by OCR1A, which is set to the same value, so it comes once per period.
+	* The clock select bits CS13:CS10 divide the clock by 2^(clockSelect-1), see ShiftPWM_timerPrescaler.
+	* See the ATtiny85 Datasheet 12.3.1 for the registers. */
+	unsigned int compareValue = CalculateCompareValue(m_ledFrequency);
+	TCCR1 = _BV(CTC1) | clockSelect;
+	OCR1C = compareValue;
+	OCR1A = compareValue;
+	bitSet(TIMSK,OCIE1A);
+}
+#else
+void CShiftPWM::InitTimer1(unsigned char clockSelect){
 	/* Configure timer1 in CTC mode: clear the timer on compare match
 	* See the Atmega328 Datasheet 15.9.2 for an explanation on CTC mode.
 	* See table 15-4 in the datasheet. */
@@ -334,26 +1681,24 @@ void CShiftPWM::InitTimer1(void){
 	bitClear(TCCR1A,WGM10);
 
 
-	/*  Select clock source: internal I/O clock, without a prescaler
-	*  This is the fastest possible clock source for the highest accuracy.
-	*  See table 15-5 in the datasheet. */
+	/*  Select clock source: internal I/O clock, with the smallest prescaler for which OCR1A fits in 16 bits.
+	*  Without a prescaler, this is the fastest possible clock source for the highest accuracy.
+	*  The prescaler is only needed for very low frequencies. See table 15-5 in the datasheet. */
 
-	bitSet(TCCR1B,CS10);
-	bitClear(TCCR1B,CS11);
-	bitClear(TCCR1B,CS12);
+	TCCR1B = (TCCR1B & ~(_BV(CS12) | _BV(CS11) | _BV(CS10))) | clockSelect;
 
 	/* The timer will generate an interrupt when the value we load in OCR1A matches the timer value.
 	* One period of the timer, from 0 to OCR1A will therefore be (OCR1A+1)/(timer clock frequency).
 	* We want the frequency of the timer to be (LED frequency)*(number of brightness levels)
 	* So the value we want for OCR1A is: timer clock frequency/(LED frequency * number of bightness levels)-1 */
-	m_prescaler = 1;
-	OCR1A = round((float) F_CPU/((float) m_ledFrequency*((float) m_maxBrightness+1)))-1;
+	OCR1A = CalculateCompareValue(m_ledFrequency);
 	/* Finally enable the timer interrupt, see datasheet  15.11.8) */
 	bitSet(TIMSK1,OCIE1A);
 }
+#endif
 
 #if defined(OCR2A)
-void CShiftPWM::InitTimer2(void){
+void CShiftPWM::InitTimer2(unsigned char clockSelect){
 	/* Configure timer2 in CTC mode: clear the timer on compare match
 	* See the Atmega328 Datasheet 15.9.2 for an explanation on CTC mode.
 	* See table 17-8 in the datasheet. */
@@ -362,51 +1707,26 @@ void CShiftPWM::InitTimer2(void){
 	bitSet(TCCR2A,WGM21);
 	bitClear(TCCR2A,WGM20);
 
-	/*  Select clock source: internal I/O clock, calculate most suitable prescaler
-	*  This is only an 8 bit timer, so choose the prescaler so that OCR2A fits in 8 bits.
-	*  See table 15-5 in the datasheet. */
-	int compare_value =  round((float) F_CPU/((float) m_ledFrequency*((float) m_maxBrightness+1))-1);
-	if(compare_value <= 255){
-		m_prescaler = 1;
-		bitClear(TCCR2B,CS22); bitClear(TCCR2B,CS21); bitClear(TCCR2B,CS20);
-	}
-	else if(compare_value/8 <=255){
-		m_prescaler = 8;
-		bitClear(TCCR2B,CS22); bitSet(TCCR2B,CS21); bitClear(TCCR2B,CS20);
-	}
-	else
-		if(compare_value/32 <=255){
-			m_prescaler = 32;
-			bitClear(TCCR2B,CS22); bitSet(TCCR2B,CS21); bitSet(TCCR2B,CS20);
-		}
-		else if(compare_value/64 <= 255){
-			m_prescaler = 64;
-			bitSet(TCCR2B,CS22); bitClear(TCCR2B,CS21); bitClear(TCCR2B,CS20);
-		}
-		else if(compare_value/128 <= 255){
-			m_prescaler = 128;
-			bitSet(TCCR2B,CS22); bitClear(TCCR2B,CS21); bitSet(TCCR2B,CS20);
-		}
-		else if(compare_value/256 <= 255){
-			m_prescaler = 256;
-			bitSet(TCCR2B,CS22); bitSet(TCCR2B,CS21); bitClear(TCCR2B,CS20);
-		}
-
-		/* The timer will generate an interrupt when the value we load in OCR2A matches the timer value.
-		* One period of the timer, from 0 to OCR2A will therefore be (OCR2A+1)/(timer clock frequency).
-		* We want the frequency of the timer to be (LED frequency)*(number of brightness levels)
-		* So the value we want for OCR2A is: timer clock frequency/(LED frequency * number of bightness levels)-1 */
-		OCR2A = round(   (  (float) F_CPU / (float) m_prescaler ) /  ( (float) m_ledFrequency*( (float) m_maxBrightness+1) ) -1);
-		/* Finally enable the timer interrupt, see datasheet  15.11.8) */
-		bitSet(TIMSK2,OCIE2A);
+	/*  Select clock source: internal I/O clock, with the most suitable prescaler
+	*  This is only an 8 bit timer, so Start chose the prescaler so that OCR2A fits in 8 bits.
+	*  See table 17-9 in the datasheet. */
+	TCCR2B = (TCCR2B & ~(_BV(CS22) | _BV(CS21) | _BV(CS20))) | clockSelect;
+
+	/* The timer will generate an interrupt when the value we load in OCR2A matches the timer value.
+	* One period of the timer, from 0 to OCR2A will therefore be (OCR2A+1)/(timer clock frequency).
+	* We want the frequency of the timer to be (LED frequency)*(number of brightness levels)
+	* So the value we want for OCR2A is: timer clock frequency/(LED frequency * number of bightness levels)-1 */
+	OCR2A = CalculateCompareValue(m_ledFrequency);
+	/* Finally enable the timer interrupt, see datasheet  15.11.8) */
+	bitSet(TIMSK2,OCIE2A);
 }
 #endif
 
 #if defined(OCR3A)
-// Arduino Leonardo or Micro
-void CShiftPWM::InitTimer3(void){
+// Arduino Leonardo, Micro or Mega
+void CShiftPWM::InitTimer3(unsigned char clockSelect){
 	/*
-	* Only available on Leonardo and micro.
+	* Only available on Leonardo, Micro and Mega.
 	* Configure timer3 in CTC mode: clear the timer on compare match
 	* See the Atmega32u4 Datasheet 15.10.2 for an explanation on CTC mode.
 	* See table 14-5 in the datasheet. */
@@ -417,69 +1737,448 @@ void CShiftPWM::InitTimer3(void){
 	bitClear(TCCR3A,WGM30);
 
 
-	/*  Select clock source: internal I/O clock, without a prescaler
-	*  This is the fastest possible clock source for the highest accuracy.
-	*  See table 15-5 in the datasheet. */
+	/*  Select clock source: internal I/O clock, with the smallest prescaler for which OCR3A fits in 16 bits.
+	*  See table 14-6 in the datasheet. */
 
-	bitSet(TCCR3B,CS30);
-	bitClear(TCCR3B,CS31);
-	bitClear(TCCR3B,CS32);
+	TCCR3B = (TCCR3B & ~(_BV(CS32) | _BV(CS31) | _BV(CS30))) | clockSelect;
 
 	/* The timer will generate an interrupt when the value we load in OCR1A matches the timer value.
 	* One period of the timer, from 0 to OCR1A will therefore be (OCR1A+1)/(timer clock frequency).
 	* We want the frequency of the timer to be (LED frequency)*(number of brightness levels)
 	* So the value we want for OCR1A is: timer clock frequency/(LED frequency * number of bightness levels)-1 */
-	m_prescaler = 1;
-	OCR3A = round((float) F_CPU/((float) m_ledFrequency*((float) m_maxBrightness+1)))-1;
+	OCR3A = CalculateCompareValue(m_ledFrequency);
 	/* Finally enable the timer interrupt, see datasheet  15.11.8) */
 	bitSet(TIMSK3,OCIE3A);
 }
 #endif
 
+#if defined(OCR4A)
+void CShiftPWM::InitTimer4(unsigned char clockSelect){
+#if defined(TC4H)
+	/* Atmega32u4 (Leonardo, Micro): timer4 is a 10 bit high speed timer, which can be clocked by the PLL.
+	* The PLL runs at 48 MHz for USB, so the steps of the interrupt period are 3 times finer than with the 16 MHz I/O clock.
+	* In normal mode, the timer counts up to OCR4C (TOP) and then starts at 0 again.
+	* OCR4A gets the same value, so the compare and match A interrupt fires once per period.
+	* See the Atmega32u4 Datasheet chapter 15 and 6.10 (PLL). */
+	TCCR4A = 0; // PWM4A and PWM4B off, outputs disconnected
+	TCCR4C = 0; // PWM4D off
+	TCCR4D = 0; // WGM41:40 = 0: normal mode
+	TCCR4E = 0;
+
+	if(!(PLLCSR & _BV(PLLE))){
+		// USB is not used, so the PLL is off. Start it and wait until it is locked.
+		#if F_CPU == 16000000UL
+		PLLCSR = _BV(PINDIV) | _BV(PLLE); // the PLL input has to be 8 MHz
+		#else
+		PLLCSR = _BV(PLLE);
+		#endif
+		while(!(PLLCSR & _BV(PLOCK)));
+	}
+	// The timer input is the PLL output divided by PLLTM. The PLL runs at 96 MHz if USB divides it by 2 (PLLUSB), otherwise at 48 MHz.
+	// The timer can run at 64 MHz at most, so divide 96 MHz by 2. Both give a timer clock of 48 MHz.
+	if(PLLFRQ & _BV(PLLUSB)){
+		PLLFRQ |= _BV(PLLTM1) | _BV(PLLTM0);
+	}
+	else{
+		PLLFRQ = (PLLFRQ & ~_BV(PLLTM1)) | _BV(PLLTM0);
+	}
+
+	/* The timer has 10 bits, so Start chose the smallest prescaler for which TOP fits in 10 bits.
+	* The prescaler is a power of 2: clock select value n divides by 2^(n-1). See table 15-14 in the datasheet. */
+	unsigned int top = CalculateCompareValue(m_ledFrequency);
+
+	// The high bits are written to TC4H first, the low byte write then writes all 10 bits at once.
+	TC4H = top>>8;
+	OCR4C = top & 0xFF;
+	TC4H = top>>8;
+	OCR4A = top & 0xFF;
+	TCCR4B = clockSelect;
+	bitSet(TIMSK4,OCIE4A);
+#else
+	/* Arduino Mega: timer4 is a 16 bit timer, configured in CTC mode like timer 1 and 3.
+	* See the Atmega2560 Datasheet 17.9.2 for an explanation on CTC mode. */
+
+	bitSet(TCCR4B,WGM42);
+	bitClear(TCCR4B,WGM43);
+	bitClear(TCCR4A,WGM41);
+	bitClear(TCCR4A,WGM40);
+
+	// Internal I/O clock, with the smallest prescaler for which OCR4A fits in 16 bits
+	TCCR4B = (TCCR4B & ~(_BV(CS42) | _BV(CS41) | _BV(CS40))) | clockSelect;
+
+	OCR4A = CalculateCompareValue(m_ledFrequency);
+	bitSet(TIMSK4,OCIE4A);
+#endif
+}
+#endif
+
+#if defined(OCR5A)
+void CShiftPWM::InitTimer5(unsigned char clockSelect){
+	/* Arduino Mega: timer5 is a 16 bit timer, configured in CTC mode like timer 1 and 3.
+	* See the Atmega2560 Datasheet 17.9.2 for an explanation on CTC mode. */
 
+	bitSet(TCCR5B,WGM52);
+	bitClear(TCCR5B,WGM53);
+	bitClear(TCCR5A,WGM51);
+	bitClear(TCCR5A,WGM50);
 
-void CShiftPWM::PrintInterruptLoad(void){
-	//This function prints information on the interrupt settings for ShiftPWM
-	//It runs a delay loop 2 times: once with interrupts enabled, once disabled.
-	//From the difference in duration, it can calculate the load of the interrupt on the program.
+	// Internal I/O clock, with the smallest prescaler for which OCR5A fits in 16 bits
+	TCCR5B = (TCCR5B & ~(_BV(CS52) | _BV(CS51) | _BV(CS50))) | clockSelect;
 
-	unsigned long start1,end1,time1,start2,end2,time2,k;
-	double load, cycles_per_int, interrupt_frequency;
+	OCR5A = CalculateCompareValue(m_ledFrequency);
+	bitSet(TIMSK5,OCIE5A);
+}
+#endif
+
+
+
+unsigned char CShiftPWM::HardwareLatchChannel(void){
+	// Returns 'B' or 'C' if the latch pin is the OCnB or OCnC output of the timer in use, 0 if it is not.
+	unsigned char pinTimer = digitalPinToTimer(m_latchPin);
+	if(m_timer==1){
+		// Timer1 of the ATtiny85 uses OCR1C as TOP, it has no fast PWM mode with OCR1A as TOP.
+		#if !defined(SHIFTPWM_TINY_TIMER1)
+		if(pinTimer==TIMER1B) return 'B';
+		#if defined(OCR1C)
+		if(pinTimer==TIMER1C) return 'C';
+		#endif
+		#endif
+	}
+	#if defined(OCR2A)
+	else if(m_timer==2){
+		if(pinTimer==TIMER2B) return 'B';
+	}
+	#endif
+	#if defined(OCR3A)
+	else if(m_timer==3){
+		if(pinTimer==TIMER3B) return 'B';
+		if(pinTimer==TIMER3C) return 'C';
+	}
+	#endif
+	#if defined(OCR4A) && !defined(TC4H)
+	// The high speed timer4 of the 32u4 has no fast PWM mode with OCR4A as TOP, so it cannot generate the latch pulse.
+	else if(m_timer==4){
+		if(pinTimer==TIMER4B) return 'B';
+		if(pinTimer==TIMER4C) return 'C';
+	}
+	#endif
+	#if defined(OCR5A)
+	else if(m_timer==5){
+		if(pinTimer==TIMER5B) return 'B';
+		if(pinTimer==TIMER5C) return 'C';
+	}
+	#endif
+	return 0;
+}
 
+void CShiftPWM::InitHardwareLatch(void){
+	/* Switch the timer from CTC mode to fast PWM mode with OCRnA as TOP. The interrupt period stays the same.
+	* The latch pin (OCnB or OCnC) is set in inverting mode: it is cleared at BOTTOM and set on compare match.
+	* The compare value is one timer clock before TOP, so the rising edge that latches the shift registers
+	* comes from the timer hardware at exactly the same moment every period, independent of interrupt latency.
+	* The interrupt (at TOP) then shifts out the data for the next edge. It has to finish within one period.
+	* See the Atmega328 Datasheet 15.9.3 for fast PWM mode and table 15-3 for the compare output mode. */
+	unsigned char channel = HardwareLatchChannel();
 
 	if(m_timer==1){
-		if(TIMSK1 & (1<<OCIE1A)){
-			// interrupt is enabled, continue
+		#if !defined(SHIFTPWM_TINY_TIMER1)
+		// Mode 15: fast PWM, TOP = OCR1A
+		bitSet(TCCR1B,WGM13);
+		bitSet(TCCR1B,WGM12);
+		bitSet(TCCR1A,WGM11);
+		bitSet(TCCR1A,WGM10);
+		if(channel=='B'){
+			OCR1B = OCR1A-1;
+			TCCR1A |= _BV(COM1B1) | _BV(COM1B0);
 		}
-		else{
-			// interrupt is disabled
-			Serial.println(F("Interrupt is disabled."));
-			return;
+		#if defined(OCR1C)
+		else if(channel=='C'){
+			OCR1C = OCR1A-1;
+			TCCR1A |= _BV(COM1C1) | _BV(COM1C0);
+		}
+		#endif
+		#endif
+	}
+	#if defined(OCR2A)
+	else if(m_timer==2){
+		// Mode 7: fast PWM, TOP = OCR2A
+		bitSet(TCCR2B,WGM22);
+		bitSet(TCCR2A,WGM21);
+		bitSet(TCCR2A,WGM20);
+		OCR2B = OCR2A-1;
+		TCCR2A |= _BV(COM2B1) | _BV(COM2B0);
+	}
+	#endif
+	#if defined(OCR3A)
+	else if(m_timer==3){
+		// Mode 15: fast PWM, TOP = OCR3A
+		bitSet(TCCR3B,WGM33);
+		bitSet(TCCR3B,WGM32);
+		bitSet(TCCR3A,WGM31);
+		bitSet(TCCR3A,WGM30);
+		if(channel=='B'){
+			OCR3B = OCR3A-1;
+			TCCR3A |= _BV(COM3B1) | _BV(COM3B0);
+		}
+		else if(channel=='C'){
+			OCR3C = OCR3A-1;
+			TCCR3A |= _BV(COM3C1) | _BV(COM3C0);
 		}
 	}
-	#if defined(USBCON)
-		else if(m_timer==3){
-			if(TIMSK3 & (1<<OCIE3A)){
-				// interrupt is enabled, continue
-			}
-			else{
-				// interrupt is disabled
-				Serial.println(F("Interrupt is disabled."));
-				return;
-			}
+	#endif
+	#if defined(OCR4A) && !defined(TC4H)
+	else if(m_timer==4){
+		// Mode 15: fast PWM, TOP = OCR4A
+		bitSet(TCCR4B,WGM43);
+		bitSet(TCCR4B,WGM42);
+		bitSet(TCCR4A,WGM41);
+		bitSet(TCCR4A,WGM40);
+		if(channel=='B'){
+			OCR4B = OCR4A-1;
+			TCCR4A |= _BV(COM4B1) | _BV(COM4B0);
 		}
-	#else
-		else if(m_timer==2){
-			if(TIMSK2 & (1<<OCIE2A)){
-				// interrupt is enabled, continue
-			}
-			else{
-				// interrupt is disabled
-				Serial.println(F("Interrupt is disabled."));
-				return;
-			}
+		else if(channel=='C'){
+			OCR4C = OCR4A-1;
+			TCCR4A |= _BV(COM4C1) | _BV(COM4C0);
+		}
+	}
+	#endif
+	#if defined(OCR5A)
+	else if(m_timer==5){
+		// Mode 15: fast PWM, TOP = OCR5A
+		bitSet(TCCR5B,WGM53);
+		bitSet(TCCR5B,WGM52);
+		bitSet(TCCR5A,WGM51);
+		bitSet(TCCR5A,WGM50);
+		if(channel=='B'){
+			OCR5B = OCR5A-1;
+			TCCR5A |= _BV(COM5B1) | _BV(COM5B0);
+		}
+		else if(channel=='C'){
+			OCR5C = OCR5A-1;
+			TCCR5A |= _BV(COM5C1) | _BV(COM5C0);
+		}
+	}
+	#endif
+}
+
+bool CShiftPWM::TimerInterruptEnabled(void){
+	if(m_timer==1){
+		#if defined(SHIFTPWM_TINY_TIMER1)
+		return TIMSK & (1<<OCIE1A);
+		#else
+		return TIMSK1 & (1<<OCIE1A);
+		#endif
+	}
+	#if defined(OCR2A)
+	else if(m_timer==2){
+		return TIMSK2 & (1<<OCIE2A);
+	}
+	#endif
+	#if defined(OCR3A)
+	else if(m_timer==3){
+		return TIMSK3 & (1<<OCIE3A);
+	}
+	#endif
+	#if defined(OCR4A)
+	else if(m_timer==4){
+		return TIMSK4 & (1<<OCIE4A);
+	}
+	#endif
+	#if defined(OCR5A)
+	else if(m_timer==5){
+		return TIMSK5 & (1<<OCIE5A);
+	}
+	#endif
+	return 0;
+}
+
+void CShiftPWM::EnableTimerInterrupt(void){
+	if(m_timer==1){
+		#if defined(SHIFTPWM_TINY_TIMER1)
+		bitSet(TIMSK,OCIE1A);
+		#else
+		bitSet(TIMSK1,OCIE1A);
+		#endif
+	}
+	#if defined(OCR2A)
+	else if(m_timer==2){
+		bitSet(TIMSK2,OCIE2A);
+	}
+	#endif
+	#if defined(OCR3A)
+	else if(m_timer==3){
+		bitSet(TIMSK3,OCIE3A);
+	}
+	#endif
+	#if defined(OCR4A)
+	else if(m_timer==4){
+		bitSet(TIMSK4,OCIE4A);
+	}
+	#endif
+	#if defined(OCR5A)
+	else if(m_timer==5){
+		bitSet(TIMSK5,OCIE5A);
+	}
+	#endif
+}
+
+void CShiftPWM::DisableTimerInterrupt(void){
+	if(m_timer==1){
+		#if defined(SHIFTPWM_TINY_TIMER1)
+		bitClear(TIMSK,OCIE1A);
+		#else
+		bitClear(TIMSK1,OCIE1A);
+		#endif
+	}
+	#if defined(OCR2A)
+	else if(m_timer==2){
+		bitClear(TIMSK2,OCIE2A);
+	}
+	#endif
+	#if defined(OCR3A)
+	else if(m_timer==3){
+		bitClear(TIMSK3,OCIE3A);
+	}
+	#endif
+	#if defined(OCR4A)
+	else if(m_timer==4){
+		bitClear(TIMSK4,OCIE4A);
+	}
+	#endif
+	#if defined(OCR5A)
+	else if(m_timer==5){
+		bitClear(TIMSK5,OCIE5A);
+	}
+	#endif
+}
+
+unsigned int CShiftPWM::TimerCompareValue(void){
+	if(m_timer==1){
+		#if defined(SHIFTPWM_TINY_TIMER1)
+		return OCR1C; // TOP
+		#else
+		return OCR1A;
+		#endif
+	}
+	#if defined(OCR2A)
+	else if(m_timer==2){
+		return OCR2A;
+	}
+	#endif
+	#if defined(OCR3A)
+	else if(m_timer==3){
+		return OCR3A;
+	}
+	#endif
+	#if defined(TC4H)
+	else if(m_timer==4){
+		unsigned int low = OCR4C; // reading the low byte copies the high bits to TC4H
+		return low | ((unsigned int) TC4H<<8);
+	}
+	#elif defined(OCR4A)
+	else if(m_timer==4){
+		return OCR4A;
+	}
+	#endif
+	#if defined(OCR5A)
+	else if(m_timer==5){
+		return OCR5A;
+	}
+	#endif
+	return 0;
+}
+
+void CShiftPWM::SetTimerCompareValue(unsigned int compareValue){
+	// Changes the interrupt period while the timer runs, for the load governor. The prescaler stays the same,
+	// so the value is limited to the size of the timer. The counter does not skip a period:
+	// - With the hardware latch, the timer is in fast PWM mode, where OCRnA and OCRnB are double buffered by the timer
+	//   and only take effect at TOP.
+	// - In CTC mode, the counter would run to its maximum if it is already past the new value. It is restarted instead,
+	//   so one step is a bit longer.
+	unsigned char channel = m_hardwareLatch ? HardwareLatchChannel() : 0;
+	uint8_t oldSREG = SREG;
+	cli(); // the 16 bit registers are written with the temporary high byte register, which the interrupt could change
+	if(m_timer==1){
+		#if defined(SHIFTPWM_TINY_TIMER1)
+		if(compareValue > 255) compareValue = 255;
+		OCR1C = compareValue;
+		OCR1A = compareValue;
+		if(TCNT1 >= compareValue) TCNT1 = 0;
+		#else
+		OCR1A = compareValue;
+		if(channel=='B') OCR1B = compareValue-1;
+		#if defined(OCR1C)
+		if(channel=='C') OCR1C = compareValue-1;
+		#endif
+		if(!m_hardwareLatch && TCNT1 >= compareValue) TCNT1 = 0;
+		#endif
+	}
+	#if defined(OCR2A)
+	else if(m_timer==2){
+		if(compareValue > 255) compareValue = 255;
+		OCR2A = compareValue;
+		if(channel=='B') OCR2B = compareValue-1;
+		if(!m_hardwareLatch && TCNT2 >= compareValue) TCNT2 = 0;
+	}
+	#endif
+	#if defined(OCR3A)
+	else if(m_timer==3){
+		OCR3A = compareValue;
+		if(channel=='B') OCR3B = compareValue-1;
+		if(channel=='C') OCR3C = compareValue-1;
+		if(!m_hardwareLatch && TCNT3 >= compareValue) TCNT3 = 0;
+	}
+	#endif
+	#if defined(TC4H)
+	else if(m_timer==4){
+		if(compareValue > 1023) compareValue = 1023;
+		TC4H = compareValue>>8;
+		OCR4C = compareValue & 0xFF;
+		TC4H = compareValue>>8;
+		OCR4A = compareValue & 0xFF;
+		unsigned int count = TCNT4; // reading the low byte copies the high bits to TC4H
+		count |= (unsigned int) TC4H<<8;
+		if(count >= compareValue){
+			TC4H = 0;
+			TCNT4 = 0;
 		}
+	}
+	#elif defined(OCR4A)
+	else if(m_timer==4){
+		OCR4A = compareValue;
+		if(channel=='B') OCR4B = compareValue-1;
+		if(channel=='C') OCR4C = compareValue-1;
+		if(!m_hardwareLatch && TCNT4 >= compareValue) TCNT4 = 0;
+	}
+	#endif
+	#if defined(OCR5A)
+	else if(m_timer==5){
+		OCR5A = compareValue;
+		if(channel=='B') OCR5B = compareValue-1;
+		if(channel=='C') OCR5C = compareValue-1;
+		if(!m_hardwareLatch && TCNT5 >= compareValue) TCNT5 = 0;
+	}
 	#endif
+	SREG = oldSREG;
+}
+
+void CShiftPWM::PrintInterruptLoad(void){
+	//This function prints information on the interrupt settings for ShiftPWM
+	//It runs a delay loop 2 times: once with interrupts enabled, once disabled.
+	//From the difference in duration, it can calculate the load of the interrupt on the program.
+
+	unsigned long start1,end1,time1,start2,end2,time2,k;
+
+	if(m_idle){
+		Serial.println(F("Interrupt is idle: all outputs are fully on or off. See SetIdleShutdown."));
+		return;
+	}
+	if(!TimerInterruptEnabled()){
+		// interrupt is disabled
+		Serial.println(F("Interrupt is disabled."));
+		return;
+	}
 
 	//run with interrupt enabled
 	start1 = micros();
@@ -490,19 +2189,7 @@ void CShiftPWM::PrintInterruptLoad(void){
 	time1 = end1-start1;
 
 	//Disable Interrupt
-	if(m_timer==1){
-		bitClear(TIMSK1,OCIE1A);
-	}
-	#if defined(USBCON)
-		else if(m_timer==3){
-			bitClear(TIMSK3,OCIE3A);
-		}
-	#else
-		else if(m_timer==2){
-			bitClear(TIMSK2,OCIE2A);
-		}
-	#endif
-
+	DisableTimerInterrupt();
 
 	// run with interrupt disabled
 	start2 = micros();
@@ -512,64 +2199,93 @@ void CShiftPWM::PrintInterruptLoad(void){
 	end2 = micros();
 	time2 = end2-start2;
 
-	// ready for calculations
-	load = (double)(time1-time2)/(double)(time1);
-	if(m_timer==1){
-		interrupt_frequency = (F_CPU/m_prescaler)/(OCR1A+1);
+	// ready for calculations, in integers: the load in 0.1%, the frequencies in 0.1 Hz
+	unsigned long loadPerMille = ((time1-time2)*1000)/time1;
+	unsigned long timerClocksPerInt = (unsigned long) (TimerCompareValue()+1)*m_prescaler;
+	unsigned int interruptsPerRow = (unsigned int) m_maxBrightness+1;
+	if(m_bamBits){
+		// The compare value changes with each bit, use the average of a row
+		interruptsPerRow = m_bamBits;
+		timerClocksPerInt = ((unsigned long) (m_bamLongest >> (m_bamBits-1))*m_maxBrightness*m_prescaler)/m_bamBits;
 	}
-	#if defined(USBCON)
-		else if(m_timer==3){
-			interrupt_frequency = (F_CPU/m_prescaler)/(OCR3A+1);
-		}
-	#else
-		else if(m_timer==2){
-			interrupt_frequency = (F_CPU/m_prescaler)/(OCR2A+1);
-		}
-	#endif
-	cycles_per_int = load*(F_CPU/interrupt_frequency);
+	unsigned long cpuCyclesPerInt = timerClocksPerInt;
+	if(m_timerClock!=F_CPU){
+		cpuCyclesPerInt /= m_timerClock/F_CPU; // timer4 of the 32u4 runs at a multiple of F_CPU
+	}
+	unsigned long cycles_per_int = (cpuCyclesPerInt/1000)*loadPerMille + ((cpuCyclesPerInt%1000)*loadPerMille)/1000;
+	unsigned long interrupt_frequency = (m_timerClock*10 + timerClocksPerInt/2)/timerClocksPerInt;
 
 	//Ready to print information
-	Serial.print(F("Load of interrupt: "));   Serial.println(load,10);
+	Serial.print(F("Load of interrupt: "));   PrintTenths(loadPerMille); Serial.println(F(" %"));
 	Serial.print(F("Clock cycles per interrupt: "));   Serial.println(cycles_per_int);
-	Serial.print(F("Interrupt frequency: ")); Serial.print(interrupt_frequency);   Serial.println(F(" Hz"));
-	Serial.print(F("PWM frequency: ")); Serial.print(interrupt_frequency/(m_maxBrightness+1)); Serial.println(F(" Hz"));
+	Serial.print(F("Interrupt frequency: ")); PrintTenths(interrupt_frequency);   Serial.println(F(" Hz"));
+	if(m_amountOfRows>1){
+		Serial.print(F("Row frequency: ")); PrintTenths(interrupt_frequency/interruptsPerRow); Serial.println(F(" Hz"));
+		Serial.print(F("Divided over ")); Serial.print(m_amountOfRows, DEC); Serial.print(F(" rows, to have a total refresh rate of "));
+		PrintTenths(interrupt_frequency/((unsigned long) interruptsPerRow*m_amountOfRows)); Serial.println(F(" Hz"));
+	}
+	else{
+		Serial.print(F("PWM frequency: ")); PrintTenths(interrupt_frequency/interruptsPerRow); Serial.println(F(" Hz"));
+	}
+	if(m_bamBits){
+		Serial.print(F("Bit angle modulation with ")); Serial.print(m_bamBits); Serial.print(F(" bits, the longest bit is "));
+		Serial.print(m_bamLongest); Serial.println(F(" timer clocks."));
+	}
 
+	if(m_timer==1){
+		Serial.println(F("Timer1 in use for highest precision."));
+		#if defined(USBCON)
+		Serial.println(F("add '#define SHIFTPWM_USE_TIMER3' before '#include <ShiftPWM.h>' to switch to timer 3."));
+		#elif defined(OCR2A)
+		Serial.println(F("add '#define SHIFTPWM_USE_TIMER2' before '#include <ShiftPWM.h>' to switch to timer 2."));
+		#endif
+	}
+	#if defined(TC4H)
+	else if(m_timer==4){
+		Serial.println(F("Timer4 in use, clocked by the PLL at 48 MHz."));
+	}
+	#endif
+	else{
+		Serial.print(F("Timer")); Serial.print(m_timer); Serial.println(F(" in use."));
+	}
+	char compareRegister = 'A';
+	#if defined(TC4H)
+	if(m_timer==4){
+		compareRegister = 'C'; // TOP of the high speed timer4
+	}
+	#endif
+	Serial.print(F("OCR")); Serial.print(m_timer); Serial.print(compareRegister); Serial.print(F(": ")); Serial.println(TimerCompareValue(), DEC);
+	Serial.print(F("Prescaler: ")); Serial.println(m_prescaler);
 
-	#if defined(USBCON)
-		if(m_timer==1){
-			Serial.println(F("Timer1 in use."));
-			Serial.println(F("add '#define SHIFTPWM_USE_TIMER3' before '#include <ShiftPWM.h>' to switch to timer 3."));
-			Serial.print(F("OCR1A: ")); Serial.println(OCR1A, DEC);
-			Serial.print(F("Prescaler: ")); Serial.println(m_prescaler);
+	//Re-enable Interrupt
+	EnableTimerInterrupt();
+}
+#else
+// On other platforms, the backend calls the interrupt code from a thread. It checks TimerInterruptEnabled before each period.
 
-			//Re-enable Interrupt
-			bitSet(TIMSK1,OCIE1A);
-		}
-			else if(m_timer==3){
-			Serial.println(F("Timer3 in use."));
-			Serial.print(F("OCR3A: ")); Serial.println(OCR3A, DEC);
-			Serial.print(F("Presclaler: ")); Serial.println(m_prescaler);
+unsigned char CShiftPWM::HardwareLatchChannel(void){
+	return 0;
+}
 
-			//Re-enable Interrupt
-			bitSet(TIMSK3,OCIE3A);
-		}
-	#else
-		if(m_timer==1){
-			Serial.println(F("Timer1 in use for highest precision."));
-			Serial.println(F("add '#define SHIFTPWM_USE_TIMER2' before '#include <ShiftPWM.h>' to switch to timer 2."));
-			Serial.print(F("OCR1A: ")); Serial.println(OCR1A, DEC);
-			Serial.print(F("Prescaler: ")); Serial.println(m_prescaler);
+bool CShiftPWM::TimerInterruptEnabled(void){
+	return m_interruptEnabled;
+}
 
-			//Re-enable Interrupt
-			bitSet(TIMSK1,OCIE1A);
-		}
-		else if(m_timer==2){
-			Serial.println(F("Timer2 in use."));
-			Serial.print(F("OCR2A: ")); Serial.println(OCR2A, DEC);
-			Serial.print(F("Presclaler: ")); Serial.println(m_prescaler);
+void CShiftPWM::EnableTimerInterrupt(void){
+	m_interruptEnabled = true;
+}
 
-			//Re-enable Interrupt
-			bitSet(TIMSK2,OCIE2A);
-		}
-	#endif
+void CShiftPWM::DisableTimerInterrupt(void){
+	m_interruptEnabled = false;
+}
+
+void CShiftPWM::PrintInterruptLoad(void){
+	if(!TimerInterruptEnabled()){
+		Serial.println(F("Interrupt is disabled."));
+		return;
+	}
+	unsigned long interrupt_frequency = InterruptFrequency(m_amountOfRows);
+	Serial.print(F("Interrupt frequency: ")); Serial.print(interrupt_frequency); Serial.println(F(" Hz"));
+	Serial.print(F("PWM frequency: ")); Serial.print(interrupt_frequency/(m_maxBrightness+1)); Serial.println(F(" Hz"));
 }
+#endif
@@ -22,16 +22,44 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define CShiftPWM_h
 
 #include <Arduino.h>
+#include "ShiftPWM_timer.h"
+
+// Errors are not printed, but counted and stored. See GetLastError, GetErrorCount and SetErrorCallback.
+// The value that is stored with the error is given in the comment.
+enum ShiftPWM_error{
+	ShiftPWM_errorNone = 0,
+	ShiftPWM_errorInvalidPin,		// pin number
+	ShiftPWM_errorInvalidChannel,	// channel number (channel map)
+	ShiftPWM_errorLoadTooHigh,		// amount of registers
+	ShiftPWM_errorBufferTooSmall,	// amount of registers
+	ShiftPWM_errorOutOfMemory,		// amount of registers
+	ShiftPWM_errorInvalidLatchPin,	// latch pin (hardware latch)
+	ShiftPWM_errorInvalidOEPin,		// output enable pin (master brightness)
+	ShiftPWM_errorFrequencyTooLow,	// PWM frequency (the timer cannot count that long)
+	ShiftPWM_errorInvalidClasses,	// amount of registers in the register classes
+	ShiftPWM_errorFixedRegisters,	// amount of registers (a CShiftPWMFixedChain cannot be resized)
+	ShiftPWM_errorInvalidBits,		// bits per value (bit angle modulation, see CShiftPWMMatrix::StartBAM)
+	ShiftPWM_amountOfErrorTypes
+};
+
+// Define SHIFTPWM_RELEASE for the whole build (for example with build_flags in PlatformIO, or in your compiler settings) to
+// remove the range checks on pins and channels and the diagnostic strings. It has to be defined for the library files too,
+// which is why defining it in your sketch is not enough. Errors in the configuration functions are still counted.
 
 class CShiftPWM{
 public:
-	CShiftPWM(int timerInUse, bool noSPI, int latchPin, int dataPin, int clockPin);
+	CShiftPWM(int timerInUse, bool noSPI, int latchPin, int dataPin, int clockPin, unsigned char * buffer = 0, unsigned int maxRegisters = 0, bool hardwareLatch = false);
 	~CShiftPWM();
 
 public:
 	void Start(int ledFrequency, unsigned char max_Brightness);
 	void SetAmountOfRegisters(unsigned char newAmount);
+	void SetBuffer(unsigned char * buffer, unsigned int maxRegisters);
 	void SetPinGrouping(int grouping);
+	void SetChannelMap(unsigned int * map, int amountOfChannels);
+	void SetRegisterClasses(const char * classes, unsigned char * binaryBuffer = 0);
+	int BuildChannelMap(unsigned int * map, int maxChannels, unsigned char colorsPerLed, int pinGrouping = 1,
+	                    const char * colorOrder = 0, unsigned char skippedOutputs = 0, int ledsPerRow = 0);
 	void PrintInterruptLoad(void);
 	void OneByOneSlow(void);
 	void OneByOneFast(void);
@@ -47,31 +75,212 @@ public:
 	void SetAllRGB(unsigned char r,unsigned char g,unsigned char b);
 	void SetHSV(int led, unsigned int hue, unsigned int sat, unsigned int val, int offset = 0);
 	void SetAllHSV(unsigned int hue, unsigned int sat, unsigned int val);
+	void SetOffset(int offset);
+
+	void SetBinaryOutput(int output, bool on);
+	void SetBinaryRegister(unsigned char binaryRegister, unsigned char outputs);
+	void SetAllBinary(bool on);
+	bool GetBinaryOutput(int output);
+
+	void ScaleAll(unsigned char scale);
+	void AddBuffer(const unsigned char * values);
+	void BlendBuffers(const unsigned char * from, const unsigned char * to, unsigned char amount);
+	void MaxBuffer(const unsigned char * values);
+	void MinBuffer(const unsigned char * values);
+	const unsigned char * DecodeFrame_P(const unsigned char * frame);
+
+	void SetOutputEnablePin(int pin);
+	void SetMasterBrightness(unsigned char brightness);
+	unsigned char GetMasterBrightness(void);
+
+	void SetCurrentBudget(unsigned int budget_mA, unsigned int outputCurrent_mA);
+	unsigned int GetBudgetScale(void);
+	unsigned long GetDutySum(void);
+	void RecalculateDutySum(void);
+	unsigned long GetOnTime(void);
+	unsigned long GetConsumedCharge(void);
+	void ResetOnTime(void);
+
+	void SetIdleShutdown(bool enable);
+	bool IsIdle(void);
+	void EnterIdle(void); // called by the interrupt
+
+	// Called at the start of each period by the interrupt, and by ResumeFromIdle because the idle interrupt stops at the
+	// start of a period: a new amount of registers (SetAmountOfRegisters) and a new offset (SetOffset) take effect here.
+	inline void StartPeriod(void){
+		m_activeRegisters = m_amountOfRegisters;
+		m_activeOutputs = m_amountOfOutputs;
+		m_activeStart = (m_viewStart <= m_activeOutputs) ? m_viewStart : m_activeOutputs;
+	}
+
+	void SetLoadGovernor(int minFrequency, unsigned int maxLoopMicros = 0);
+	void SetLoadDemand(unsigned char demand);
+	void UpdateLoadGovernor(void);
+	int GetGovernedFrequency(void);
+
+	unsigned long GetFrameCount(void);
+	bool FrameStarted(void);
+	void WaitForFrame(void);
+	void SetFrameCallback(void (*callback)(void));
+
+	void SetErrorCallback(void (*callback)(unsigned char error, int value));
+	unsigned char GetLastError(void);
+	int GetLastErrorValue(void);
+	unsigned int GetErrorCount(unsigned char error);
+	void ClearErrors(void);
+	void PrintLastError(void);
 
 private:
 	void OneByOne_core(int delaytime);
+	#ifndef SHIFTPWM_RELEASE
 	bool IsValidPin(int pin);
-	void InitTimer1(void);
+	bool IsValidChannel(int channel);
+	bool IsValidBinaryOutput(int output);
+	#else
+	bool IsValidPin(int pin){ return 1; }
+	bool IsValidChannel(int channel){ return 1; }
+	bool IsValidBinaryOutput(int output){ return 1; }
+	#endif
+	void ReportError(unsigned char error, int value);
+	void InitTimer1(unsigned char clockSelect);
 	
 	#if defined(OCR3A)
-		// Arduino Leonardo or Micro (32u4)
-		void InitTimer3(void);
+		// Arduino Leonardo, Micro (32u4) or Mega
+		void InitTimer3(unsigned char clockSelect);
 	#endif
 
 	#if defined(OCR2A)
-		// Normal Arduino (328)
-		void InitTimer2(void);
+		// Normal Arduino (328) or Mega
+		void InitTimer2(unsigned char clockSelect);
 	#endif
 
-	bool LoadNotTooHigh(void);
+	#if defined(OCR4A)
+		// Arduino Mega (16 bit timer), or Leonardo, Micro (32u4, 10 bit high speed timer)
+		void InitTimer4(unsigned char clockSelect);
+	#endif
+
+	#if defined(OCR5A)
+		// Arduino Mega
+		void InitTimer5(unsigned char clockSelect);
+	#endif
+
+	void StartTimer(int ledFrequency, unsigned char maxBrightness);
+	bool LoadNotTooHigh(unsigned char amountOfRegisters, unsigned char amountOfRows, unsigned char binaryRegisters = 0);
+	unsigned int StepsPerRow(void);
+	unsigned long InterruptFrequency(unsigned char amountOfRows);
+	unsigned int CalculateCompareValue(int ledFrequency);
+	void EnableTimerInterrupt(void);
+	void DisableTimerInterrupt(void);
+	unsigned int TimerCompareValue(void);
+	void SetTimerCompareValue(unsigned int compareValue);
+	unsigned char HardwareLatchChannel(void);
+	void InitHardwareLatch(void);
+	int OutputEnableTimer(void);
+	void UpdateDutyLimit(void);
+	void ValidateChannelMap(void);
+	unsigned long long OnTimeMicros(void);
+	void ApplyCurrentBudget(void);
+	void ResumeFromIdle(void);
+	unsigned long IdlePeriods(void);
+	unsigned long long IdleDutyIntegral(void);
+	void ApplyGovernedFrequency(void);
 
 	const int m_timer;
 	const bool m_noSPI;
 	const int m_latchPin;
 	const int m_dataPin;
 	const int m_clockPin;
+	const bool m_hardwareLatch; // latch pulse is generated by the timer on the OCnB/OCnC pin
 
 	int m_prescaler;
+	unsigned long m_timerClock; // clock of the timer before the prescaler. F_CPU, except for timer4 of the 32u4 on the PLL
+	#if !defined(__AVR__)
+	volatile bool m_interruptEnabled; // there are no timers, see linux/CShiftPWMLinux.h
+	#endif
+	unsigned int m_maxRegisters; // size of the buffer in registers (of all rows)
+	bool m_bufferOnHeap;
+	unsigned char m_maxBinaryRegisters; // size of m_binaryValues
+	bool m_binaryOnHeap;
+	int m_oePin; // output enable pin of the shift registers, driven with hardware PWM. -1 if not used
+	unsigned char m_masterBrightness;
+	unsigned int m_currentBudget; // mA, 0 if there is no budget
+	unsigned int m_outputCurrent; // mA of one output that is fully on
+	unsigned long m_dutyLimit; // highest allowed m_dutySum for the current budget, 0 if there is no budget
+	unsigned int m_budgetScale; // new values are multiplied by m_budgetScale/256 while the budget is exceeded
+	unsigned long m_idleStart; // millis() when the interrupt stopped
+	unsigned long m_idleDutySum; // m_dutySum when the interrupt stopped, for the energy meter
+	int m_governorMinFrequency; // lowest PWM frequency of the load governor, 0 if the governor is off
+	unsigned int m_governorMaxLoopMicros; // longest loop before the governor lowers the frequency, 0 to only use SetLoadDemand
+	unsigned char m_userDemand; // set with SetLoadDemand
+	unsigned char m_loopDemand; // from the duration of the loops, see UpdateLoadGovernor
+	unsigned char m_governorDemand; // applied demand, moves towards the higher of the two in small steps
+	unsigned long m_lastLoopMicros;
+	int m_governedFrequency; // PWM frequency the timer runs at, m_ledFrequency if the governor does not lower it
+	unsigned long long m_onTimeMicros; // on time at earlier frequencies, m_dutyIntegral only counts periods at m_governedFrequency
+	unsigned long m_lastFrameSeen; // frame count of the last FrameStarted or WaitForFrame
+
+protected:
+	// Used by CShiftPWMMatrix to change the number of rows and column registers together
+	void Resize(unsigned char amountOfRows, unsigned char amountOfRegisters);
+	// Used by CShiftPWMMatrix::StartBAM, the interrupts of the chains do not support bit angle modulation
+	void StartBAM(int ledFrequency, unsigned char bits);
+	// Used by CShiftPWMMatrix::SwapBuffers to fit a frame in the current budget before it is shown
+	void FitInCurrentBudget(unsigned char * values);
+	// Set by CShiftPWMFixedChain, whose interrupt is unrolled for its registers and reads its own array. Resize, SetBuffer
+	// and SetRegisterClasses then report an error, also when they are called through a CShiftPWM reference.
+	bool m_fixedRegisters;
+	void HSVtoRGB(unsigned int hue, unsigned int sat, unsigned int val, unsigned char &r, unsigned char &g, unsigned char &b);
+	bool TimerInterruptEnabled(void);
+
+	// Writes one value and keeps m_dutySum and m_partialOutputs up to date, without reading the other values.
+	// While the current budget is exceeded, the value is scaled down like the values that are already set.
+	// With double buffering (CShiftPWMMatrix), the value goes to the draw buffer. Its sum and budget are handled by SwapBuffers.
+	inline void StoreValue(int index, unsigned char value){
+		if(m_backValues!=0){
+			m_backValues[index] = value;
+			return;
+		}
+		if(m_budgetScale!=256){
+			value = ((unsigned int) value*m_budgetScale)>>8;
+		}
+		uint8_t oldSREG = SREG;
+		cli(); // the interrupt reads m_dutySum for the energy meter and m_partialOutputs for the idle shutdown
+		m_dutySum = m_dutySum - m_PWMValues[index] + value;
+		m_partialOutputs += IsPartialValue(value) - IsPartialValue(m_PWMValues[index]);
+		SREG = oldSREG;
+		m_PWMValues[index] = value;
+	}
+	// The buffer that the functions that set values write to: the back buffer with double buffering (CShiftPWMMatrix),
+	// otherwise the buffer that is shown
+	inline unsigned char * DrawBuffer(void){
+		return (m_backValues!=0) ? m_backValues : m_PWMValues;
+	}
+	// Call after writing the draw buffer without StoreValue. The sum of the values (see SetCurrentBudget) is only kept for the
+	// buffer that is shown, the back buffer is added up when it is swapped in.
+	inline void DrawBufferChanged(void){
+		if(m_backValues==0){
+			RecalculateDutySum();
+		}
+	}
+	// Call after StoreValue, once per function that sets values
+	inline void ValuesChanged(void){
+		if(m_dutyLimit!=0){
+			ApplyCurrentBudget();
+		}
+		if(m_idle){
+			ResumeFromIdle(); // the interrupt latches the new values
+		}
+	}
+	// A value that is not always on or always off during a period
+	inline bool IsPartialValue(unsigned char value){
+		return value!=0 && value<m_maxBrightness;
+	}
+
+private:
+	void (*m_errorCallback)(unsigned char error, int value);
+	unsigned int m_errorCounts[ShiftPWM_amountOfErrorTypes];
+	unsigned char m_lastError;
+	int m_lastErrorValue;
 
 
 public:
@@ -80,9 +289,62 @@ public:
 	unsigned char m_amountOfRegisters;
 	int m_amountOfOutputs;
 	int m_pinGrouping;
+	unsigned int * m_channelMap; // output for each channel, or 0 to use m_pinGrouping
+	int m_amountOfChannels; // channels of the map that are below m_amountOfOutputs, see ValidateChannelMap
+	int m_channelMapLength; // channels given to SetChannelMap
 	unsigned char * m_PWMValues;
 	unsigned char m_counter;
 
+	// Amount of registers used by the interrupt. Copied from m_amountOfRegisters at the start of each PWM period.
+	unsigned char m_activeRegisters;
+	int m_activeOutputs;
+
+	// Only used by the matrix interrupt (CShiftPWMMatrix). A strip is a matrix with one row.
+	// The values are stored row after row: the value of row r, column c is m_PWMValues[r*m_amountOfRegisters*8+c].
+	unsigned char m_amountOfRows;
+	unsigned char m_activeRows;
+	unsigned char m_currentRow;
+	int m_rowStart; // index of the first value of the row that is shown
+
+	// Register classes, see SetRegisterClasses. m_registerClasses has one letter for each register of the chain: 'B' for
+	// a binary register, which is sent as its byte in m_binaryValues, or 'P' for a PWM register, which uses 8 values of
+	// m_PWMValues. m_amountOfRegisters counts the PWM registers only. m_registerClasses is 0 if all registers are PWM registers.
+	const char * m_registerClasses;
+	unsigned char * m_binaryValues; // one byte per binary register, in the bit order of the interrupt (see SetBinaryRegister)
+	unsigned char m_binaryRegisters;
+
+	// Viewport, see SetOffset and CShiftPWMMatrix::SetViewport. m_activeStart is copied from m_viewStart at the start of each period.
+	// The interrupt starts reading at index m_activeStart-1 (of the row) and continues at the end after index 0. 0 means no offset.
+	int m_viewStart;
+	int m_activeStart;
+	unsigned char m_viewRow;
+	// Bit angle modulation, only used by the matrix interrupt. See CShiftPWMMatrix::StartBAM. m_counter is then the number of
+	// the bit in the row, which starts with the most significant bit: m_bamMask selects it in the values, and the timer runs
+	// m_bamTicks clocks until the next bit.
+	unsigned char m_bamBits; // 0 for PWM
+	unsigned char m_bamMask;
+	unsigned int m_bamTicks;
+	unsigned int m_bamLongest; // timer clocks of the most significant bit
+	unsigned char * m_backValues; // second buffer for double buffering, 0 if not used. See CShiftPWMMatrix::SwapBuffers
+	volatile bool m_swapPending; // m_PWMValues and m_backValues are swapped at the start of the next frame
+
+	// Sum of all values (of all rows), kept up to date by the functions that set values. See SetCurrentBudget and GetOnTime.
+	// If you write m_PWMValues directly, call RecalculateDutySum afterwards.
+	unsigned long m_dutySum;
+	// m_dutySum is added by the interrupt at the start of each period (each frame for a matrix). See GetOnTime.
+	unsigned long long m_dutyIntegral;
+
+	// Amount of values that are not 0 and below m_maxBrightness, kept up to date like m_dutySum. When it is 0, all periods
+	// are the same, so the interrupt latches the outputs once and stops until a value changes. See SetIdleShutdown.
+	int m_partialOutputs;
+	bool m_idleShutdown;
+	volatile bool m_idle; // the interrupt is stopped because the outputs do not change
+
+	// Counted by the interrupt at the start of each period (each frame for a matrix), when the new values are first shown.
+	// See GetFrameCount, FrameStarted and WaitForFrame. m_frameCallback is called by the interrupt right after, if it is not 0.
+	volatile unsigned long m_frameCount;
+	void (*m_frameCallback)(void);
+
 };
 
 #endif
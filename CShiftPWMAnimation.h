@@ -0,0 +1,170 @@
+/*
+CShiftPWMAnimation.h - Library for Arduino to PWM many outputs using shift registers
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+CShiftPWMAnimation plays an animation (a show) from program memory. The frames are compressed: a frame only contains the
+values that changed since the previous frame, and runs of the same value are stored once. Only those values are read and
+written when a frame is shown, so a long show uses little flash, almost no RAM and little time per frame.
+
+	#include <ShiftPWM.h>
+	#include <CShiftPWMAnimation.h>
+	#include "show.h" // const unsigned char show[] PROGMEM = {...}; made with tools/ShiftPWM_encode_animation.cpp
+
+	CShiftPWMAnimation player(ShiftPWM);
+
+	void setup(){
+		ShiftPWM.SetAmountOfRegisters(6);
+		ShiftPWM.Start(75, 255);
+		player.Play(show);
+	}
+
+	void loop(){
+		player.Update(); // shows the next frame when it is due
+	}
+
+The duration of a frame is a number of PWM periods (counted with CShiftPWM::GetFrameCount), which is stored in the show.
+SetTempo plays it faster or slower.
+At the end, the show continues at its loop frame, or stops on the last frame if Play was called with loop false.
+Update has to be called at least once per frame. If it is called too late, it shows all frames that are due at once,
+because each frame only contains the changes to the previous one.
+
+The format of a show, all numbers of 2 bytes are little endian:
+	byte 0-1	amount of outputs of a frame
+	byte 2-3	amount of frames
+	byte 4-5	loop frame: the frame that is shown after the last frame
+	byte 6-7	byte offset of the loop frame from the start of the show
+	byte 8		duration of a frame, in PWM periods
+	byte 9-		the frames
+A frame is a list of commands, which fill the outputs from output 0 up:
+	0x00		end of the frame, the other outputs keep their value
+	0x01-0x7F	skip 1-127 outputs, which keep their value
+	0x80-0xBF	1-64 values follow, one for each output (command-0x80+1)
+	0xC0-0xFF	one value follows, for the next 1-64 outputs (command-0xC0+1)
+The first frame and the loop frame do not skip outputs, so they do not depend on the frame that was shown before them.
+The offsets are 16 bit and the show is read with pgm_read_byte, so a show has to be in the first 64 kB of flash.
+*/
+
+#ifndef CShiftPWMAnimation_h
+#define CShiftPWMAnimation_h
+
+#include <Arduino.h>
+#include "CShiftPWM.h"
+
+class CShiftPWMAnimation{
+public:
+	CShiftPWMAnimation(CShiftPWM & pwm) : m_pwm(pwm){
+		m_show = 0;
+		m_next = 0;
+		m_frame = 0;
+		m_playing = false;
+		m_loop = true;
+		m_tempo = 256;
+		m_phase = 0;
+		m_lastFrameCount = 0;
+	}
+
+	// Shows the first frame of the show in program memory and starts playing it.
+	void Play(const unsigned char * show, bool loop = true){
+		m_show = show;
+		m_loop = loop;
+		m_next = m_pwm.DecodeFrame_P(m_show+9);
+		m_frame = 1;
+		m_phase = 0;
+		m_lastFrameCount = m_pwm.GetFrameCount();
+		m_playing = true;
+	}
+
+	// Stops the show. The last frame stays on the outputs.
+	void Stop(void){
+		m_playing = false;
+	}
+
+	// Continues a stopped show at the frame after the last one that was shown.
+	void Resume(void){
+		if(m_show!=0 && !m_playing){
+			m_lastFrameCount = m_pwm.GetFrameCount();
+			m_playing = true;
+		}
+	}
+
+	bool IsPlaying(void){
+		return m_playing;
+	}
+
+	// 256 plays the show at its own speed, 512 twice as fast, 128 at half speed.
+	void SetTempo(unsigned int tempo){
+		m_tempo = tempo;
+	}
+
+	// The frame that is shown, counting from 0
+	unsigned int GetFrame(void){
+		return m_frame-1;
+	}
+
+	// Call this in loop. Shows the next frame when it is due and returns true if a frame was shown.
+	bool Update(void){
+		if(!m_playing){
+			return false;
+		}
+		// Count the PWM periods since the last call, in 1/256 periods at the tempo.
+		unsigned long frameCount = m_pwm.GetFrameCount();
+		m_phase += (frameCount-m_lastFrameCount)*m_tempo;
+		m_lastFrameCount = frameCount;
+
+		unsigned long frameDuration = (unsigned long) pgm_read_byte(m_show+8)*256;
+		if(frameDuration==0){
+			frameDuration = 256; // at least one period
+		}
+		bool shown = false;
+		while(m_phase >= frameDuration && m_playing){
+			m_phase -= frameDuration;
+			if(m_frame >= ReadWord(2)){
+				// After the last frame
+				if(!m_loop){
+					m_playing = false;
+					break;
+				}
+				m_next = m_show+ReadWord(6);
+				m_frame = ReadWord(4);
+			}
+			m_next = m_pwm.DecodeFrame_P(m_next);
+			m_frame++;
+			shown = true;
+		}
+		return shown;
+	}
+
+private:
+	unsigned int ReadWord(unsigned char offset){
+		return pgm_read_byte(m_show+offset) | ((unsigned int) pgm_read_byte(m_show+offset+1)<<8);
+	}
+
+	CShiftPWM & m_pwm;
+	const unsigned char * m_show;
+	const unsigned char * m_next; // the frame that is shown next
+	unsigned int m_frame; // number of the next frame
+	bool m_playing;
+	bool m_loop;
+	unsigned int m_tempo;
+	unsigned long m_phase; // 1/256 PWM periods since the last frame
+	unsigned long m_lastFrameCount; // GetFrameCount of the last Update
+};
+
+#endif
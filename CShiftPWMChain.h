@@ -0,0 +1,142 @@
+/*
+CShiftPWMChain.h - Library for Arduino to PWM many outputs using shift registers
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+CShiftPWMChain can be used to drive more than one chain of shift registers, each with its own timer,
+pins, frequency, brightness levels and options. All functions of the normal ShiftPWM object are available.
+
+The pins and options are template parameters, so the interrupt function of each chain is generated
+with constant pins, just like the ShiftPWM object in ShiftPWM.h. Example for an Arduino Mega:
+
+	#include <CShiftPWMChain.h>
+
+	//                timer, noSPI, latch, data, clock, invertOutputs, balanceLoad
+	CShiftPWMChain<1, false, 8,  MOSI, SCK, false, false> stripA;
+	CShiftPWMChain<3, true,  22, 23,   24,  true,  false> stripB;
+
+	SHIFTPWM_CHAIN_ISR(1, stripA)
+	SHIFTPWM_CHAIN_ISR(3, stripB)
+
+	void setup(){
+		stripA.SetAmountOfRegisters(6);  stripA.Start(75, 255);
+		stripB.SetAmountOfRegisters(12); stripB.Start(120, 31);
+	}
+
+With constant settings, stripA.Start<75, 255, 6>() does the same, but checks them when the sketch is compiled:
+the build fails if the timer cannot run at the frequency, or if the interrupt load would be too high.
+
+Things to keep in mind:
+- There is only one SPI port. Only one chain (including the global ShiftPWM object) can use it, the others need noSPI.
+- Each chain needs its own timer. Do not use a timer that is also used by ShiftPWM.h or other libraries.
+- With viewport set to true, SetOffset can shift all outputs of the chain without copying the values.
+- With hardwareLatch set to true, the latch pin has to be the OCnB or OCnC output of the timer of the chain.
+  The timer then generates the latch pulse at a fixed moment in each period. See CShiftPWM::InitHardwareLatch.
+- The interrupts can interrupt each other. On the Mega, ports H to L are not bit addressable.
+  Writing a pin on these ports is not atomic, so do not put pins of different chains on the same port H-L.
+*/
+
+#ifndef CShiftPWMChain_h
+#define CShiftPWMChain_h
+
+#include "pins_arduino_compile_time.h" // My own version of pins arduino, which does not define the arrays in program memory
+#include <Arduino.h>
+#include "CShiftPWM.h"
+#include "ShiftPWM_core.h"
+
+template<int timer, bool noSPI, int latchPin, int dataPin, int clockPin, bool invertOutputs = false, bool balanceLoad = false, bool hardwareLatch = false, bool viewport = false>
+class CShiftPWMChain : public CShiftPWM{
+public:
+	CShiftPWMChain(unsigned char * buffer = 0, unsigned int maxRegisters = 0) : CShiftPWM(timer, noSPI, latchPin, dataPin, clockPin, buffer, maxRegisters, hardwareLatch){}
+
+	static const int timerInUse = timer;
+
+	// Called from the interrupt that is installed with SHIFTPWM_CHAIN_ISR
+	inline void HandleInterrupt(void){
+		ShiftPWM_handleInterrupt_core<latchPin, dataPin, clockPin, noSPI, invertOutputs, balanceLoad, hardwareLatch, 0, viewport>(*this);
+	}
+
+	// Same as SetAmountOfRegisters and Start, but the build fails if the timer cannot run at this frequency
+	// or if the interrupt load would be too high. See ShiftPWM_timer.h.
+	using CShiftPWM::Start;
+	template<int ledFrequency, unsigned char maxBrightness, unsigned char amountOfRegisters>
+	void Start(void){
+		ShiftPWM_checkTimerSettings<timer, noSPI, ledFrequency, maxBrightness, amountOfRegisters>();
+		SetAmountOfRegisters(amountOfRegisters);
+		Start(ledFrequency, maxBrightness);
+	}
+};
+
+/*
+CShiftPWMFixedChain is the same as CShiftPWMChain, but the number of registers is fixed at compile time.
+The values are stored in a static array inside the object, instead of on the heap.
+Because the compiler knows the number of registers and the address of the values, it can fully unroll the
+interrupt loop: there is no loop counter and m_PWMValues and m_amountOfOutputs do not have to be loaded.
+The code size of the interrupt grows with the number of registers.
+
+	CShiftPWMFixedChain<6, 1, false, 8, MOSI, SCK> strip; // 6 registers
+	SHIFTPWM_CHAIN_ISR(1, strip)
+
+Use examples/ShiftPWM_Fixed_Benchmark to compare the interrupt load of the fixed and the generic chain on your hardware.
+The load checks of Start (ShiftPWM_checkTimerSettings and LoadNotTooHigh) use the estimate of the generic chain for both.
+*/
+template<unsigned char amountOfRegisters, int timer, bool noSPI, int latchPin, int dataPin, int clockPin, bool invertOutputs = false, bool balanceLoad = false, bool hardwareLatch = false>
+class CShiftPWMFixedChain : public CShiftPWM{
+public:
+	CShiftPWMFixedChain() : CShiftPWM(timer, noSPI, latchPin, dataPin, clockPin, m_fixedValues, amountOfRegisters, hardwareLatch){
+		m_amountOfRegisters = amountOfRegisters;
+		m_amountOfOutputs = amountOfRegisters*8;
+		m_fixedRegisters = true;
+	}
+
+	static const int timerInUse = timer;
+
+	// Called from the interrupt that is installed with SHIFTPWM_CHAIN_ISR
+	inline void HandleInterrupt(void){
+		ShiftPWM_handleInterrupt_core<latchPin, dataPin, clockPin, noSPI, invertOutputs, balanceLoad, hardwareLatch, amountOfRegisters>(*this, m_fixedValues);
+	}
+
+	// Same as Start, but the build fails if the timer cannot run at this frequency or if the interrupt load would be too high.
+	using CShiftPWM::Start;
+	template<int ledFrequency, unsigned char maxBrightness>
+	void Start(void){
+		ShiftPWM_checkTimerSettings<timer, noSPI, ledFrequency, maxBrightness, amountOfRegisters>();
+		Start(ledFrequency, maxBrightness);
+	}
+
+private:
+	// The number of registers and the buffer are fixed, they cannot be changed at runtime. Hiding the setters catches this
+	// when the sketch is compiled. Through a CShiftPWM reference (CShiftPWMAnimation for example) the calls still compile,
+	// but do nothing and report ShiftPWM_errorFixedRegisters.
+	void SetAmountOfRegisters(unsigned char newAmount);
+	void SetBuffer(unsigned char * buffer, unsigned int maxRegisters);
+
+	unsigned char m_fixedValues[amountOfRegisters*8];
+};
+
+// Install the Interrupt Service Routine (ISR) for the compare and match A interrupt of the timer of a chain.
+// The timer number has to be a literal, because it is pasted into the name of the interrupt vector.
+#define SHIFTPWM_CHAIN_ISR(timer, chain) \
+	ISR(TIMER##timer##_COMPA_vect) { \
+		static_assert(timer == decltype(chain)::timerInUse, "Timer of SHIFTPWM_CHAIN_ISR does not match the timer of the chain"); \
+		chain.HandleInterrupt(); \
+	}
+
+// #endif for include once.
+#endif
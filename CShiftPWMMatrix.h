@@ -0,0 +1,361 @@
+/*
+CShiftPWMMatrix.h - Library for Arduino to PWM many outputs using shift registers
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+CShiftPWMMatrix drives a multiplexed LED matrix: a chain of column shift registers, like a normal ShiftPWM chain,
+and a chain of row shift registers that switches on one row at a time.
+It replaces the separate ShiftMatrixPWM library that was in boards/LED Matrix, including its output enable and bit angle
+modulation modes. The schematic of the matrix driver board is still there. It uses the same interrupt code as ShiftPWM,
+so it works with every timer ShiftPWM supports (1 to 5), with or without SPI for the columns.
+
+	#include <CShiftPWMMatrix.h>
+
+	//               timer, noSPI, latch, data, clock, rowLatch, rowData, rowClock, invertColumns, invertRows
+	CShiftPWMMatrix<1, false, 9, MOSI, SCK, 4, 5, 6, false, false> matrix;
+	SHIFTPWM_CHAIN_ISR(1, matrix)
+
+	void setup(){
+		matrix.SetMatrixSize(8, 2); // 8 rows, 2 column registers (16 columns)
+		matrix.Start(75, 31);       // refresh rate of 75 Hz for the whole matrix, 32 brightness levels
+		matrix.SetOne(2, 5, 31);    // row 2, column 5
+	}
+
+All other functions of ShiftPWM can be used as well. They use the output number row*columns+column.
+
+Each row gets maxBrightness+1 interrupts, so the interrupt frequency is refresh rate * (maxBrightness+1) * rows.
+matrix.Start<75, 31, 8, 2>() sets the size and starts in one call, and fails to compile if the timer cannot run at that
+frequency or if the interrupt load would be too high.
+The row register is clocked at the start of the row, and its latch is set right after the column latch. The new row
+is switched on together with its own data, so there is no blank period between rows.
+The row latch can also be connected to the column latch pin: then both registers are latched at exactly the same moment.
+In that case, pass the same pin for latchPin and rowLatchPin.
+
+The last template parameter selects how the rows are driven:
+- ShiftPWM_rowShiftRegister (default): a separate row shift register on rowLatchPin, rowDataPin and rowClockPin.
+  The row pins are written one bit at a time, once per row.
+- ShiftPWM_rowSPI: the row registers are connected after the last column register and share its latch.
+  The row bytes are sent with every interrupt, which takes about as long as one column register each,
+  but no separate pins are needed and rows and columns change with the same latch pulse. The row pins are not used.
+- ShiftPWM_rowDecoder3 / ShiftPWM_rowDecoder4: a 74HC138 (8 rows) or 74HC154 (16 rows) decoder. Its address lines
+  are rowDataPin and the next 2 or 3 bits of the same port, for example pins 4-7 (PD4-PD7) on an Uno.
+  rowDataPin has to be bit 0-5 (74HC138) or 0-4 (74HC154) of its port, so all address lines fit in the port.
+  Selecting a row is a single port write. Do not write other pins of this port from another interrupt.
+  The decoder outputs are active low, so invertRows is not used. rowLatchPin and rowClockPin are not used.
+
+	CShiftPWMMatrix<1, false, 9, MOSI, SCK, 0, 4, 0, false, false, false, ShiftPWM_rowDecoder4> matrix; // 16 rows on PD4-PD7
+
+Output enable:
+If the output enable pins (OE, active low) of the column registers are connected to a pin, pass it as columnOEPin.
+The columns are then switched off during the first interrupt of each row, while the rows are switched, and switched on
+again right after the new row is latched. This prevents ghosting from row drivers that switch slower than the columns.
+The first brightness step of each row is shorter by the duration of one interrupt, so the lowest values are a bit dimmer.
+Start sets the pin as output and keeps the columns off until the first row is latched.
+This pin cannot be used for the master brightness of SetOutputEnablePin as well.
+
+	CShiftPWMMatrix<1, false, 9, MOSI, SCK, 4, 5, 6, false, false, false, ShiftPWM_rowShiftRegister, 3> matrix; // OE on pin 3
+
+Bit angle modulation:
+StartBAM(ledFrequency, bits) uses bit angle modulation (BAM) instead of PWM. Each row then gets one interrupt per bit of the values
+instead of one per brightness level: bit n of all values of the row is shown for 2^n time units, by setting the compare value of
+the timer in each interrupt. maxBrightness is 2^bits-1, so StartBAM(100, 6) gives 64 brightness levels with 6 interrupts per row
+instead of 64, and the interrupt load is much lower.
+The shortest bit is one time unit of 1/(ledFrequency*maxBrightness*rows) seconds and has to be longer than the interrupt,
+which limits the refresh rate and the number of column registers. StartBAM checks this like Start does, and
+matrix.StartBAM<100, 6, 8, 2>() fails to compile if it cannot work. The longest bit has to fit in the timer as well: with the
+8 bit timer2 it can only be 256 clocks, which leaves too little time for the shortest bit, so use a 16 bit timer.
+Each row starts with its most significant bit, so the output enable pin only shortens the longest bit. balanceLoad is not used.
+
+	matrix.SetMatrixSize(8, 2);
+	matrix.StartBAM(100, 6); // 100 Hz, 64 brightness levels
+
+Drawing and double buffering:
+SetPixel, SetPixelRGB, SetPixelHSV, Fill, Blit and Blit_P write to the draw buffer. Normally this is the buffer that is shown.
+After EnableDoubleBuffer, they write to a second buffer instead, and SwapBuffers shows it at the start of the next frame.
+This way the interrupt never shows a half drawn frame. SwapBuffers waits for the swap (at most one frame).
+
+	matrix.SetMatrixSize(8, 3);
+	matrix.EnableDoubleBuffer();
+	matrix.SetPixelHSV(0, 2, 120, 255, 255); // row 0, RGB led 2
+	matrix.Blit_P(frame);                    // a full frame of rows*columns values in program memory
+	matrix.SwapBuffers();
+
+SetPixelRGB and SetPixelHSV scale the values to maxBrightness and use the pin grouping, like SetRGB: with pinGrouping 1
+the colors of each led are next to each other (RGBRGB..), led x of a row uses columns 3x, 3x+1 and 3x+2.
+The functions of ShiftPWM (SetOne, SetRGB, SetAll, ...) also write to the draw buffer, so they are not lost at the swap.
+A current budget set with SetCurrentBudget is applied to the draw buffer before it is shown.
+
+Viewport:
+SetViewport(rowOffset, colOffset) shifts the whole image: row r shows row r+rowOffset and column c shows column c+colOffset,
+wrapping around at the edges. Scrolling text or images only needs a new offset, the values are not copied.
+The offset is applied at the start of the next frame.
+*/
+
+#ifndef CShiftPWMMatrix_h
+#define CShiftPWMMatrix_h
+
+#include "pins_arduino_compile_time.h" // My own version of pins arduino, which does not define the arrays in program memory
+#include <Arduino.h>
+#include "CShiftPWM.h"
+#include "ShiftPWM_core.h"
+#include "CShiftPWMChain.h" // SHIFTPWM_CHAIN_ISR
+
+template<int timer, bool noSPI, int latchPin, int dataPin, int clockPin, int rowLatchPin, int rowDataPin, int rowClockPin,
+         bool invertColumns = false, bool invertRows = false, bool balanceLoad = false, int rowDriver = ShiftPWM_rowShiftRegister,
+         int columnOEPin = -1>
+class CShiftPWMMatrix : public CShiftPWM{
+public:
+	CShiftPWMMatrix(unsigned char * buffer = 0, unsigned int maxRegisters = 0) : CShiftPWM(timer, noSPI, latchPin, dataPin, clockPin, buffer, maxRegisters){
+		m_ownedBuffer = 0;
+		m_originalBuffer = 0;
+	}
+
+	static const int timerInUse = timer;
+
+	// Called from the interrupt that is installed with SHIFTPWM_CHAIN_ISR
+	inline void HandleInterrupt(void){
+		ShiftPWM_handleInterrupt_matrix<latchPin, dataPin, clockPin, noSPI, invertColumns, balanceLoad,
+		                                rowLatchPin, rowDataPin, rowClockPin, invertRows, rowDriver, columnOEPin, timer>(*this);
+	}
+
+	~CShiftPWMMatrix(){
+		DisableDoubleBuffer();
+	}
+
+	// Sets the number of rows and column registers. The change takes effect at the start of the next frame.
+	// With a buffer from SetBuffer or the constructor, rows*columnRegisters has to fit in it.
+	// Double buffering is switched off, because the back buffer has the old size. Enable it again afterwards.
+	void SetMatrixSize(unsigned char rows, unsigned char columnRegisters){
+		DisableDoubleBuffer();
+		Resize(rows, columnRegisters);
+	}
+
+	void SetAmountOfRegisters(unsigned char newAmount){
+		DisableDoubleBuffer();
+		CShiftPWM::SetAmountOfRegisters(newAmount);
+	}
+
+	void SetBuffer(unsigned char * buffer, unsigned int maxRegisters){
+		DisableDoubleBuffer();
+		CShiftPWM::SetBuffer(buffer, maxRegisters);
+	}
+
+	// Uses a second buffer of rows*columns values for drawing. If no buffer is given, it is allocated on the heap.
+	// The current frame is copied to it. Returns false if there is not enough memory.
+	bool EnableDoubleBuffer(unsigned char * buffer = 0){
+		DisableDoubleBuffer();
+		if(buffer==0){
+			buffer = (unsigned char *) malloc(m_amountOfOutputs);
+			if(buffer==0){
+				return false;
+			}
+			m_ownedBuffer = buffer;
+		}
+		memcpy(buffer, m_PWMValues, m_amountOfOutputs);
+		m_originalBuffer = m_PWMValues;
+		m_backValues = buffer;
+		return true;
+	}
+
+	void DisableDoubleBuffer(void){
+		if(m_backValues==0){
+			return;
+		}
+		WaitForSwap();
+		// Make sure the buffer that stays in use is the original one, which is owned by ShiftPWM.
+		// If the buffers are swapped an odd number of times, show the original one again with the current frame.
+		if(m_PWMValues!=m_originalBuffer){
+			memcpy(m_backValues, m_PWMValues, m_amountOfOutputs);
+			m_swapPending = true;
+			WaitForSwap();
+		}
+		m_backValues = 0;
+		if(m_ownedBuffer!=0){
+			free(m_ownedBuffer);
+			m_ownedBuffer = 0;
+		}
+	}
+
+	// Shows the draw buffer at the start of the next frame and waits until it is shown.
+	// With keepContents, the new frame is copied to the new draw buffer, so you can continue drawing on it.
+	// Otherwise the draw buffer contains the frame before, which is faster if you redraw the whole frame anyway.
+	void SwapBuffers(bool keepContents = true){
+		if(m_backValues==0){
+			return;
+		}
+		FitInCurrentBudget(m_backValues); // the new frame is never shown above the budget
+		m_swapPending = true;
+		WaitForSwap();
+		RecalculateDutySum(); // the sum of the new frame was not kept up to date while drawing
+		if(keepContents){
+			memcpy(m_backValues, m_PWMValues, m_amountOfOutputs);
+		}
+	}
+
+	// Shifts the image by rowOffset rows and colOffset columns, wrapping around at the edges. Negative offsets are allowed.
+	void SetViewport(int rowOffset, int colOffset){
+		int columns = m_amountOfRegisters*8;
+		if(m_amountOfRows==0 || columns==0){
+			return;
+		}
+		rowOffset = rowOffset % m_amountOfRows;
+		if(rowOffset<0){
+			rowOffset += m_amountOfRows;
+		}
+		colOffset = colOffset % columns;
+		if(colOffset<0){
+			colOffset += columns;
+		}
+		m_viewRow = rowOffset;
+		m_viewStart = colOffset; // 0 is read as the end of the row
+	}
+
+	// Returns the buffer that SetPixel and the other drawing functions write to
+	using CShiftPWM::DrawBuffer;
+
+	void SetPixel(int row, int col, unsigned char value){
+		if(row<m_amountOfRows && col<m_amountOfRegisters*8){
+			StoreValue(row*m_amountOfRegisters*8+col, value); // writes to the draw buffer
+			ValuesChanged();
+		}
+	}
+
+	void SetPixelRGB(int row, int led, unsigned char r, unsigned char g, unsigned char b){
+		int columns = m_amountOfRegisters*8;
+		int col = led+(led/m_pinGrouping)*m_pinGrouping*2; // first column of the led, see CShiftPWM::SetRGB
+		if(row<m_amountOfRows && col+2*m_pinGrouping<columns){
+			r = ( (unsigned int) r * m_maxBrightness)>>8;
+			g = ( (unsigned int) g * m_maxBrightness)>>8;
+			b = ( (unsigned int) b * m_maxBrightness)>>8;
+			int index = row*columns+col;
+			StoreValue(index, r); // writes to the draw buffer
+			StoreValue(index+m_pinGrouping, g);
+			StoreValue(index+2*m_pinGrouping, b);
+			ValuesChanged();
+		}
+	}
+
+	void SetPixelHSV(int row, int led, unsigned int hue, unsigned int sat, unsigned int val){
+		unsigned char r,g,b;
+		HSVtoRGB(hue, sat, val, r, g, b);
+		SetPixelRGB(row, led, r, g, b);
+	}
+
+	void Fill(unsigned char value){
+		memset(DrawBuffer(), value, m_amountOfOutputs);
+		DrawBufferChanged();
+	}
+
+	// Copies a full frame of rows*columns values, row after row, to the draw buffer.
+	void Blit(const unsigned char * frame){
+		memcpy(DrawBuffer(), frame, m_amountOfOutputs);
+		DrawBufferChanged();
+	}
+
+	// Same as Blit, for a frame in program memory (PROGMEM)
+	void Blit_P(const unsigned char * frame){
+		memcpy_P(DrawBuffer(), frame, m_amountOfOutputs);
+		DrawBufferChanged();
+	}
+
+	void Start(int ledFrequency, unsigned char maxBrightness){
+		InitPins();
+		CShiftPWM::Start(ledFrequency, maxBrightness);
+	}
+
+	// Same as SetMatrixSize and Start, but the build fails if the timer cannot run at this frequency
+	// or if the interrupt load would be too high. See ShiftPWM_timer.h.
+	template<int ledFrequency, unsigned char maxBrightness, unsigned char rows, unsigned char columnRegisters>
+	void Start(void){
+		ShiftPWM_checkTimerSettings<timer, noSPI, ledFrequency, maxBrightness, columnRegisters, rows>();
+		SetMatrixSize(rows, columnRegisters);
+		Start(ledFrequency, maxBrightness);
+	}
+
+	// Starts with bit angle modulation instead of PWM. The values have bits bits: maxBrightness is 2^bits-1.
+	void StartBAM(int ledFrequency, unsigned char bits){
+		InitPins();
+		CShiftPWM::StartBAM(ledFrequency, bits);
+	}
+
+	// Same as SetMatrixSize and StartBAM, but the build fails if the timer cannot run at this frequency
+	// or if the shortest bit would be shorter than the interrupt. See ShiftPWM_timer.h.
+	template<int ledFrequency, unsigned char bits, unsigned char rows, unsigned char columnRegisters>
+	void StartBAM(void){
+		ShiftPWM_checkBAMSettings<timer, noSPI, ledFrequency, bits, columnRegisters, rows>();
+		SetMatrixSize(rows, columnRegisters);
+		StartBAM(ledFrequency, bits);
+	}
+
+	using CShiftPWM::SetOne;
+	void SetOne(int row, int col, unsigned char value){
+		SetOne(row*m_amountOfRegisters*8+col, value);
+	}
+
+private:
+	// For a matrix, use SetViewport instead
+	void SetOffset(int offset);
+
+	// Sets up the output enable pin and the row pins, before Start or StartBAM starts the interrupt
+	void InitPins(void){
+		if(columnOEPin>=0){
+			// Output enable is active low. Keep the columns off until the interrupt has latched the first row.
+			pinMode(columnOEPin, OUTPUT);
+			digitalWrite(columnOEPin, HIGH);
+		}
+		if(rowDriver==ShiftPWM_rowShiftRegister){
+			// Switch all rows off before the interrupt starts, by shifting an 'off' bit into every row register output.
+			pinMode(rowLatchPin, OUTPUT);
+			pinMode(rowDataPin, OUTPUT);
+			pinMode(rowClockPin, OUTPUT);
+			digitalWrite(rowLatchPin, LOW);
+			digitalWrite(rowDataPin, invertRows ? HIGH : LOW);
+			for(int k=0; k<m_amountOfRows; k++){
+				digitalWrite(rowClockPin, LOW);
+				digitalWrite(rowClockPin, HIGH);
+			}
+			digitalWrite(rowLatchPin, HIGH);
+		}
+		else if(rowDriver==ShiftPWM_rowDecoder3 || rowDriver==ShiftPWM_rowDecoder4){
+			// Set the address lines as outputs. They are on one port, so the data direction register is written directly.
+			const uint8_t addressMask = ((rowDriver==ShiftPWM_rowDecoder3) ? 0x07 : 0x0F) << digital_pin_to_bit_PGM_ct[rowDataPin];
+			*portModeRegister(digitalPinToPort(rowDataPin)) |= addressMask;
+		}
+	}
+
+	void WaitForSwap(void){
+		if(!TimerInterruptEnabled()){
+			// The interrupt does not run, swap here.
+			if(m_swapPending){
+				unsigned char * front = m_PWMValues;
+				m_PWMValues = m_backValues;
+				m_backValues = front;
+				m_swapPending = false;
+			}
+			return;
+		}
+		while(m_swapPending); // the interrupt swaps the buffers at the start of the next frame
+	}
+
+	unsigned char * m_ownedBuffer; // back buffer allocated by EnableDoubleBuffer, 0 if it was given by the user
+	unsigned char * m_originalBuffer; // buffer of ShiftPWM when double buffering was enabled
+};
+
+// #endif for include once.
+#endif
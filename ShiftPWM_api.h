@@ -0,0 +1,75 @@
+/*
+ShiftPWM_api.h - Library for Arduino to PWM many outputs using shift registers
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+ShiftPWM.h and ShiftPWM_isr.h define the ShiftPWM object and its interrupt, so they can only be included in one file.
+All other files of a sketch or firmware include this header instead. It only declares the ShiftPWM object,
+so they can use all its functions, but it does not need the pins and it does not generate an interrupt.
+
+	// main.cpp, or the .ino file
+	const int ShiftPWM_latchPin = 8;
+	const bool ShiftPWM_invertOutputs = false;
+	const bool ShiftPWM_balanceLoad = false;
+	#include <ShiftPWM.h>
+
+	// effects.cpp
+	#include <ShiftPWM_api.h>
+	void Rainbow(void){ ShiftPWM.SetAllHSV(millis()/10 % 360, 255, 255); }
+
+The settings can also be a type, which several files can share. See ShiftPWM_isr.h.
+*/
+
+#ifndef ShiftPWM_api_h
+#define ShiftPWM_api_h
+
+#include <Arduino.h>
+#include "CShiftPWM.h"
+
+// Settings of the ShiftPWM object, used by SHIFTPWM_DEFINE in ShiftPWM_isr.h. Derive from this type and redefine the
+// settings that are different. They are constants, so the interrupt is generated with constant pins, like in ShiftPWM.h.
+struct ShiftPWM_defaultSettings{
+	static constexpr int timer = 1;					// has to match the timer of SHIFTPWM_DEFINE
+	static constexpr int latchPin = -1;				// has to be set
+	static constexpr bool noSPI = false;
+	static constexpr int dataPin = -1;				// only used with noSPI, otherwise MOSI (DO on the ATtiny)
+	static constexpr int clockPin = -1;				// only used with noSPI, otherwise SCK (USCK on the ATtiny)
+	static constexpr bool invertOutputs = false;
+	static constexpr bool balanceLoad = false;
+	static constexpr bool hardwareLatch = false;	// see SHIFTPWM_HARDWARE_LATCH in ShiftPWM.h
+	static constexpr bool viewport = false;			// see SHIFTPWM_VIEWPORT in ShiftPWM.h
+	static constexpr unsigned char maxRegisters = 0;	// size of a static buffer, 0 uses the heap. See SHIFTPWM_MAX_REGISTERS in ShiftPWM.h
+};
+
+// Defined by ShiftPWM.h or SHIFTPWM_DEFINE, in one file.
+extern CShiftPWM ShiftPWM;
+
+#if defined(__AVR__)
+// Same as ShiftPWM.SetAmountOfRegisters and ShiftPWM.Start, but the build fails if the timer cannot run at this frequency
+// or if the interrupt load would be too high. For example: ShiftPWM_start<LedSettings, 75, 255, 6>(); See ShiftPWM_timer.h.
+template<class settings, int ledFrequency, unsigned char maxBrightness, unsigned char amountOfRegisters>
+inline void ShiftPWM_start(void){
+	ShiftPWM_checkTimerSettings<settings::timer, settings::noSPI, ledFrequency, maxBrightness, amountOfRegisters>();
+	ShiftPWM.SetAmountOfRegisters(amountOfRegisters);
+	ShiftPWM.Start(ledFrequency, maxBrightness);
+}
+#endif
+
+// #endif for include once.
+#endif
@@ -0,0 +1,732 @@
+/*
+ShiftPWM_core.h - Library for Arduino to PWM many outputs using shift registers
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+This file contains the interrupt code that is shared by the global ShiftPWM object (ShiftPWM.h),
+the CShiftPWMChain template (CShiftPWMChain.h) and the CShiftPWMMatrix template (CShiftPWMMatrix.h).
+
+The pins and options are template parameters. This way they are constant at compile time,
+and the compiler can still replace the port lookups by sbi and cbi instructions.
+The function is only instantiated in the file where the pins are set, like it was before.
+
+Only ShiftPWM_registerByte is used on other platforms than the AVR (see linux/CShiftPWMLinux.h), the rest is AVR specific.
+*/
+
+#ifndef ShiftPWM_core_h
+#define ShiftPWM_core_h
+
+#if defined(__AVR__)
+#include "pins_arduino_compile_time.h" // My own version of pins arduino, which does not define the arrays in program memory
+#endif
+#include <Arduino.h>
+#include "CShiftPWM.h"
+
+// The ATtiny24/44/84 names the timer 1 compare interrupt differently
+#if defined(TIM1_COMPA_vect) && !defined(TIMER1_COMPA_vect)
+#define TIMER1_COMPA_vect TIM1_COMPA_vect
+#endif
+
+#if defined(__AVR__)
+// The macro below uses 3 instructions per pin to generate the byte to transfer with SPI
+// Retreive duty cycle setting from memory (ldd, 2 clockcycles)
+// Compare with the counter (cp, 1 clockcycle) --> result is stored in carry
+// Use the rotate over carry right to shift the compare result into the byte. (1 clockcycle).
+#define add_one_pin_to_byte(sendbyte, counter, ledPtr) \
+{ \
+	unsigned char pwmval=*ledPtr; \
+	asm volatile ("cp %0, %1" : /* No outputs */ : "r" (counter), "r" (pwmval): ); \
+	asm volatile ("ror %0" : "+r" (sendbyte) : "r" (sendbyte) : ); 	\
+}
+
+// Same, but rotate left: the first value ends up in bit 7. For ports that send bit 7 first, like the USI of the ATtiny.
+#define add_one_pin_to_byte_msb(sendbyte, counter, ledPtr) \
+{ \
+	unsigned char pwmval=*ledPtr; \
+	asm volatile ("cp %0, %1" : /* No outputs */ : "r" (counter), "r" (pwmval): ); \
+	asm volatile ("rol %0" : "+r" (sendbyte) : "r" (sendbyte) : ); 	\
+}
+
+// The macros below are used for bit angle modulation (see CShiftPWMMatrix::StartBAM). They use 4 instructions per pin:
+// Retreive duty cycle setting from memory (ldd, 2 clockcycles)
+// Keep only the bit that is shown in this interrupt (and, 1 clockcycle)
+// Compare with zero (cp, 1 clockcycle) --> carry is set if the bit was set
+// Use the rotate over carry to shift the result into the byte. (1 clockcycle).
+#define add_one_bam_bit_to_byte(sendbyte, mask, ledPtr) \
+{ \
+	unsigned char pwmval=*ledPtr; \
+	asm volatile ("and %0, %1" : "+r" (pwmval) : "r" (mask) : ); \
+	asm volatile ("cp __zero_reg__, %0" : /* No outputs */ : "r" (pwmval) : ); \
+	asm volatile ("ror %0" : "+r" (sendbyte) : "r" (sendbyte) : ); \
+}
+
+#define add_one_bam_bit_to_byte_msb(sendbyte, mask, ledPtr) \
+{ \
+	unsigned char pwmval=*ledPtr; \
+	asm volatile ("and %0, %1" : "+r" (pwmval) : "r" (mask) : ); \
+	asm volatile ("cp __zero_reg__, %0" : /* No outputs */ : "r" (pwmval) : ); \
+	asm volatile ("rol %0" : "+r" (sendbyte) : "r" (sendbyte) : ); \
+}
+
+#endif
+
+// Calculates one byte from the 8 PWM values before ledPtr. ledPtr is moved to the previous register.
+// The value at ledPtr-1 ends up in bit 0, which is sent first and ends up on the last output of the register.
+// With msbFirst, the byte is mirrored: the value at ledPtr-1 ends up in bit 7, for a port that sends bit 7 first.
+// With bam, counter is the mask of the bit that is shown (bit angle modulation), and balanceLoad is not used.
+template<bool invertOutputs, bool balanceLoad, bool msbFirst = false, bool bam = false>
+static inline unsigned char ShiftPWM_registerByte(unsigned char * &ledPtr, unsigned char &counter) __attribute__((always_inline));
+template<bool invertOutputs, bool balanceLoad, bool msbFirst, bool bam>
+static inline unsigned char ShiftPWM_registerByte(unsigned char * &ledPtr, unsigned char &counter){
+	unsigned char sendbyte;  // no need to initialize, all bits are replaced
+	if(balanceLoad && !bam){
+		counter +=8; // distribute the load by using a shifted counter per shift register
+	}
+	#if defined(__AVR__)
+	if(bam && msbFirst){
+		add_one_bam_bit_to_byte_msb(sendbyte, counter, --ledPtr);
+		add_one_bam_bit_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte_msb(sendbyte, counter,  --ledPtr);
+
+		add_one_bam_bit_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte_msb(sendbyte, counter,  --ledPtr);
+	}
+	else if(bam){
+		add_one_bam_bit_to_byte(sendbyte, counter, --ledPtr);
+		add_one_bam_bit_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte(sendbyte, counter,  --ledPtr);
+
+		add_one_bam_bit_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_bam_bit_to_byte(sendbyte, counter,  --ledPtr);
+	}
+	else if(msbFirst){
+		add_one_pin_to_byte_msb(sendbyte, counter, --ledPtr);
+		add_one_pin_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte_msb(sendbyte, counter,  --ledPtr);
+
+		add_one_pin_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte_msb(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte_msb(sendbyte, counter,  --ledPtr);
+	}
+	else{
+		add_one_pin_to_byte(sendbyte, counter, --ledPtr);
+		add_one_pin_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte(sendbyte, counter,  --ledPtr);
+
+		add_one_pin_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte(sendbyte, counter,  --ledPtr);
+		add_one_pin_to_byte(sendbyte, counter,  --ledPtr);
+	}
+	#else
+	// Same as the rotate over carry above
+	sendbyte = 0;
+	for(unsigned char k=0; k<8; k++){
+		unsigned char pwmval = *(--ledPtr);
+		bool on = bam ? (pwmval & counter)!=0 : counter < pwmval;
+		if(msbFirst){
+			sendbyte = (sendbyte<<1) | (on ? 0x01 : 0);
+		}
+		else{
+			sendbyte = (sendbyte>>1) | (on ? 0x80 : 0);
+		}
+	}
+	#endif
+	if(invertOutputs){
+		sendbyte = ~sendbyte; // Invert the byte if needed.
+	}
+	return sendbyte;
+}
+
+#if defined(__AVR__)
+// The inline function below uses normal output pins to send one bit to the SPI port.
+// This function is used in the noSPI mode and is useful if you need the SPI port for something else.
+// It is a lot 2.5x slower than the SPI version.
+// With bam, counter is the mask of the bit that is shown (bit angle modulation).
+static inline void pwm_output_one_pin(volatile uint8_t * const clockPort, volatile uint8_t * const dataPort,\
+                                  const uint8_t clockBit, const uint8_t dataBit, const bool invertOutputs, \
+                                  unsigned char counter, unsigned char * ledPtr, const bool bam = false){
+    bitClear(*clockPort, clockBit);
+    if(bam){
+      bitWrite(*dataPort, dataBit, ((*(ledPtr) & counter)==0) == invertOutputs );
+    }
+    else if(invertOutputs){
+      bitWrite(*dataPort, dataBit, *(ledPtr)<=counter );
+    }
+    else{
+      bitWrite(*dataPort, dataBit, *(ledPtr)>counter );
+    }
+    bitSet(*clockPort, clockBit);
+}
+
+// The hardware port that sends the bytes when noSPI is false.
+// Most AVRs have an SPI port, which sends a byte in the background while the next byte is calculated.
+// The ATtiny25/45/85 and ATtiny24/44/84 have a USI instead. In three-wire mode it is clocked by writing USICR: each write
+// of USITC toggles the clock pin, and USICLK shifts the data register. This takes 2 cycles per bit, so a byte is sent
+// in 17 cycles and there is nothing to wait for. The USI sends bit 7 first, so the bytes are calculated mirrored.
+// The data pin is DO and the clock pin is USCK, see ShiftPWM_spiDataPin and ShiftPWM_spiClockPin in pins_arduino_compile_time.h.
+#if defined(SPDR)
+const bool ShiftPWM_spiMsbFirst = false;
+
+static inline void ShiftPWM_spiBegin(void){
+	SPDR = 0; // write bogus bit to the SPI, because in the loop there is a receive before send.
+}
+
+static inline void ShiftPWM_spiWrite(unsigned char sendbyte) __attribute__((always_inline));
+static inline void ShiftPWM_spiWrite(unsigned char sendbyte){
+	while (!(SPSR & _BV(SPIF)));    // wait for last send to finish and retreive answer. Retreive must be done, otherwise the SPI will not work.
+	SPDR = sendbyte; // Send the byte to the SPI
+}
+
+static inline void ShiftPWM_spiEnd(void){
+	while (!(SPSR & _BV(SPIF))); // wait for last send to complete.
+}
+#elif defined(USIDR)
+const bool ShiftPWM_spiMsbFirst = true;
+
+static inline void ShiftPWM_spiBegin(void){}
+
+static inline void ShiftPWM_spiWrite(unsigned char sendbyte) __attribute__((always_inline));
+static inline void ShiftPWM_spiWrite(unsigned char sendbyte){
+	const unsigned char clockLow = _BV(USIWM0) | _BV(USITC);				// toggle the clock: rising edge, the register reads the data bit
+	const unsigned char clockHigh = _BV(USIWM0) | _BV(USITC) | _BV(USICLK);	// toggle it back and shift the next bit to DO
+	USIDR = sendbyte;
+	asm volatile (
+		"out %[usicr], %[low]"  "\n\t" "out %[usicr], %[high]" "\n\t"
+		"out %[usicr], %[low]"  "\n\t" "out %[usicr], %[high]" "\n\t"
+		"out %[usicr], %[low]"  "\n\t" "out %[usicr], %[high]" "\n\t"
+		"out %[usicr], %[low]"  "\n\t" "out %[usicr], %[high]" "\n\t"
+		"out %[usicr], %[low]"  "\n\t" "out %[usicr], %[high]" "\n\t"
+		"out %[usicr], %[low]"  "\n\t" "out %[usicr], %[high]" "\n\t"
+		"out %[usicr], %[low]"  "\n\t" "out %[usicr], %[high]" "\n\t"
+		"out %[usicr], %[low]"  "\n\t" "out %[usicr], %[high]" "\n\t"
+		: /* No outputs */
+		: [usicr] "I" (_SFR_IO_ADDR(USICR)), [low] "r" (clockLow), [high] "r" (clockHigh)
+	);
+}
+
+static inline void ShiftPWM_spiEnd(void){}
+#endif
+
+// Calculates one byte from 8 PWM values and sends it with SPI. ledPtr is moved to the previous register.
+// The SPI sends the previous byte while this byte is calculated, so it waits for the SPI before writing the new byte.
+template<bool invertOutputs, bool balanceLoad, bool bam = false>
+static inline void ShiftPWM_sendRegisterSPI(unsigned char * &ledPtr, unsigned char &counter) __attribute__((always_inline));
+template<bool invertOutputs, bool balanceLoad, bool bam>
+static inline void ShiftPWM_sendRegisterSPI(unsigned char * &ledPtr, unsigned char &counter){
+	ShiftPWM_spiWrite(ShiftPWM_registerByte<invertOutputs, balanceLoad, ShiftPWM_spiMsbFirst, bam>(ledPtr, counter));
+}
+
+// Same as above, but with port manipulation instead of SPI.
+template<bool invertOutputs, bool balanceLoad, bool bam = false>
+static inline void ShiftPWM_sendRegisterNoSPI(volatile uint8_t * const clockPort, volatile uint8_t * const dataPort,
+                                  const uint8_t clockBit, const uint8_t dataBit,
+                                  unsigned char * &ledPtr, unsigned char &counter) __attribute__((always_inline));
+template<bool invertOutputs, bool balanceLoad, bool bam>
+static inline void ShiftPWM_sendRegisterNoSPI(volatile uint8_t * const clockPort, volatile uint8_t * const dataPort,
+                                  const uint8_t clockBit, const uint8_t dataBit,
+                                  unsigned char * &ledPtr, unsigned char &counter){
+	if(balanceLoad && !bam){
+		counter +=8; // distribute the load by using a shifted counter per shift register
+	}
+	pwm_output_one_pin(clockPort, dataPort, clockBit, dataBit, invertOutputs, counter, --ledPtr, bam);  // This takes 12 or 13 clockcycles
+	pwm_output_one_pin(clockPort, dataPort, clockBit, dataBit, invertOutputs, counter, --ledPtr, bam);
+	pwm_output_one_pin(clockPort, dataPort, clockBit, dataBit, invertOutputs, counter, --ledPtr, bam);
+	pwm_output_one_pin(clockPort, dataPort, clockBit, dataBit, invertOutputs, counter, --ledPtr, bam);
+	pwm_output_one_pin(clockPort, dataPort, clockBit, dataBit, invertOutputs, counter, --ledPtr, bam);
+	pwm_output_one_pin(clockPort, dataPort, clockBit, dataBit, invertOutputs, counter, --ledPtr, bam);
+	pwm_output_one_pin(clockPort, dataPort, clockBit, dataBit, invertOutputs, counter, --ledPtr, bam);
+	pwm_output_one_pin(clockPort, dataPort, clockBit, dataBit, invertOutputs, counter, --ledPtr, bam);
+}
+
+// Sends the byte of a binary register as it is, see CShiftPWM::SetRegisterClasses. The byte is stored in the bit order
+// of ShiftPWM_registerByte, so it is sent in the same order as the port would send it: bit 0 first, or bit 7 first on the USI.
+template<bool noSPI, bool invertOutputs>
+static inline void ShiftPWM_sendBinaryRegister(volatile uint8_t * const clockPort, volatile uint8_t * const dataPort,
+                                  const uint8_t clockBit, const uint8_t dataBit, unsigned char sendbyte) __attribute__((always_inline));
+template<bool noSPI, bool invertOutputs>
+static inline void ShiftPWM_sendBinaryRegister(volatile uint8_t * const clockPort, volatile uint8_t * const dataPort,
+                                  const uint8_t clockBit, const uint8_t dataBit, unsigned char sendbyte){
+	if(invertOutputs){
+		sendbyte = ~sendbyte;
+	}
+	if(!noSPI){
+		ShiftPWM_spiWrite(sendbyte);
+	}
+	else{
+		for(unsigned char k=8; k>0; --k){
+			bitClear(*clockPort, clockBit);
+			if(ShiftPWM_spiMsbFirst){
+				bitWrite(*dataPort, dataBit, sendbyte & 0x80);
+				sendbyte <<= 1;
+			}
+			else{
+				bitWrite(*dataPort, dataBit, sendbyte & 0x01);
+				sendbyte >>= 1;
+			}
+			bitSet(*clockPort, clockBit);
+		}
+	}
+}
+
+// Sends a chain with binary and PWM registers, from the last register to the first. The letters of m_registerClasses
+// select for each register if the next byte of m_binaryValues is sent, or the next 8 values at ledPtr are compared.
+// A binary register costs a load and a send instead of 8 compares. See CShiftPWM::SetRegisterClasses.
+template<bool noSPI, bool invertOutputs, bool balanceLoad>
+static inline void ShiftPWM_sendClasses(volatile uint8_t * const clockPort, volatile uint8_t * const dataPort,
+                                  const uint8_t clockBit, const uint8_t dataBit,
+                                  CShiftPWM & pwm, unsigned char * ledPtr, unsigned char &counter){
+	unsigned char registers = pwm.m_activeRegisters + pwm.m_binaryRegisters;
+	const char * classPtr = &pwm.m_registerClasses[registers];
+	unsigned char * binaryPtr = &pwm.m_binaryValues[pwm.m_binaryRegisters];
+	for(unsigned char i = registers; i>0;--i){
+		if(*(--classPtr)=='B'){
+			ShiftPWM_sendBinaryRegister<noSPI, invertOutputs>(clockPort, dataPort, clockBit, dataBit, *(--binaryPtr));
+		}
+		else if(!noSPI){
+			ShiftPWM_sendRegisterSPI<invertOutputs, balanceLoad>(ledPtr, counter);
+		}
+		else{
+			ShiftPWM_sendRegisterNoSPI<invertOutputs, balanceLoad>(clockPort, dataPort, clockBit, dataBit, ledPtr, counter);
+		}
+	}
+}
+
+// Sends a compile time constant number of registers. The recursion is resolved by the compiler,
+// which results in a fully unrolled loop without a loop counter.
+template<unsigned char registers, bool noSPI, bool invertOutputs, bool balanceLoad>
+struct ShiftPWM_unrolled{
+	static inline void send(volatile uint8_t * const clockPort, volatile uint8_t * const dataPort,
+	                        const uint8_t clockBit, const uint8_t dataBit,
+	                        unsigned char * &ledPtr, unsigned char &counter) __attribute__((always_inline)){
+		if(!noSPI){
+			ShiftPWM_sendRegisterSPI<invertOutputs, balanceLoad>(ledPtr, counter);
+		}
+		else{
+			ShiftPWM_sendRegisterNoSPI<invertOutputs, balanceLoad>(clockPort, dataPort, clockBit, dataBit, ledPtr, counter);
+		}
+		ShiftPWM_unrolled<registers-1, noSPI, invertOutputs, balanceLoad>::send(clockPort, dataPort, clockBit, dataBit, ledPtr, counter);
+	}
+};
+
+template<bool noSPI, bool invertOutputs, bool balanceLoad>
+struct ShiftPWM_unrolled<0, noSPI, invertOutputs, balanceLoad>{
+	static inline void send(volatile uint8_t * const, volatile uint8_t * const, const uint8_t, const uint8_t,
+	                        unsigned char * &, unsigned char &){}
+};
+
+// Sends a number of registers, starting at ledPtr and going down. Used by the viewport (see CShiftPWM::SetOffset).
+// The values are a circular buffer of length values starting at first: after first, it continues at the last value.
+// ledPtr points one past the first value to send. The registers before the wrap are sent directly from the buffer.
+// The one register that contains the wrap is copied to a small array, so only one register per interrupt is slower.
+// With bam, counter is the mask of the bit that is shown (bit angle modulation, only used by the matrix interrupt).
+template<bool noSPI, bool invertOutputs, bool balanceLoad, bool bam = false>
+static inline void ShiftPWM_sendCircular(volatile uint8_t * const clockPort, volatile uint8_t * const dataPort,
+                                  const uint8_t clockBit, const uint8_t dataBit,
+                                  unsigned char * first, int length, unsigned char * ledPtr,
+                                  unsigned char registers, unsigned char &counter){
+	int beforeWrap = ledPtr-first;
+	unsigned char direct = (beforeWrap>>3 < registers) ? beforeWrap>>3 : registers;
+	for(unsigned char i = direct; i>0;--i){
+		if(!noSPI){
+			ShiftPWM_sendRegisterSPI<invertOutputs, balanceLoad, bam>(ledPtr, counter);
+		}
+		else{
+			ShiftPWM_sendRegisterNoSPI<invertOutputs, balanceLoad, bam>(clockPort, dataPort, clockBit, dataBit, ledPtr, counter);
+		}
+	}
+	registers -= direct;
+	if(registers==0){
+		return;
+	}
+	unsigned char rest = beforeWrap & 7;
+	if(rest){
+		// This register contains the wrap. Copy its 8 values in the order they are read: from high to low index.
+		unsigned char wrapped[8];
+		unsigned char * last = first+length;
+		for(unsigned char k=8; k>8-rest; --k){
+			wrapped[k-1] = *(--ledPtr);
+		}
+		ledPtr = last;
+		for(unsigned char k=8-rest; k>0; --k){
+			wrapped[k-1] = *(--ledPtr);
+		}
+		unsigned char * wrappedPtr = &wrapped[8];
+		if(!noSPI){
+			ShiftPWM_sendRegisterSPI<invertOutputs, balanceLoad, bam>(wrappedPtr, counter);
+		}
+		else{
+			ShiftPWM_sendRegisterNoSPI<invertOutputs, balanceLoad, bam>(clockPort, dataPort, clockBit, dataBit, wrappedPtr, counter);
+		}
+		registers--;
+	}
+	else{
+		ledPtr = first+length;
+	}
+	for(unsigned char i = registers; i>0;--i){
+		if(!noSPI){
+			ShiftPWM_sendRegisterSPI<invertOutputs, balanceLoad, bam>(ledPtr, counter);
+		}
+		else{
+			ShiftPWM_sendRegisterNoSPI<invertOutputs, balanceLoad, bam>(clockPort, dataPort, clockBit, dataBit, ledPtr, counter);
+		}
+	}
+}
+
+// When fixedRegisters is not 0, the number of registers is a compile time constant and fixedValues points to a
+// statically allocated array of fixedRegisters*8 values. The loop over the registers is then fully unrolled.
+// When hardwareLatch is true, the latch pin is not written here: the timer generates the latch pulse (see CShiftPWM::InitHardwareLatch).
+// When viewport is true, the outputs are shifted by the offset set with CShiftPWM::SetOffset. This costs a few cycles per interrupt.
+template<int latchPin, int dataPin, int clockPin, bool noSPI, bool invertOutputs, bool balanceLoad, bool hardwareLatch = false, unsigned char fixedRegisters = 0, bool viewport = false>
+static inline void ShiftPWM_handleInterrupt_core(CShiftPWM & pwm, unsigned char * fixedValues = 0){
+	sei(); //enable interrupt nesting to prevent disturbing other interrupt functions (servo's for example).
+
+	// Look up which bit of which output register corresponds to the pin.
+	// This should be constant, so the compiler can optimize this code away and use sbi and cbi instructions
+	// The compiler only knows this if this function is compiled in the same file as the pin setting.
+	// That is the reason the full funcion is in the header file, instead of only the prototype.
+	// If this function is defined in cpp files of the library, it is compiled seperately from the main file.
+	// The compiler does not recognize the pins/ports as constant and sbi and cbi instructions cannot be used.
+
+	volatile uint8_t * const latchPort = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[latchPin]];
+	const uint8_t latchBit =  digital_pin_to_bit_PGM_ct[latchPin];
+
+	volatile uint8_t * const clockPort = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[clockPin]];
+	volatile uint8_t * const dataPort  = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[dataPin]];
+	const uint8_t clockBit =  digital_pin_to_bit_PGM_ct[clockPin];
+	const uint8_t dataBit =   digital_pin_to_bit_PGM_ct[dataPin];
+
+	// Define a pointer that will be used to access the values for each output.
+	// Let it point one past the last value, because it is decreased before it is used.
+
+	unsigned char * ledPtr;
+	if(fixedRegisters){
+		ledPtr=&fixedValues[fixedRegisters*8]; // constant address, no need to load m_PWMValues
+	}
+	else{
+		ledPtr=&pwm.m_PWMValues[pwm.m_activeOutputs];
+	}
+
+	// Write shift register latch clock low
+	if(!hardwareLatch){
+		bitClear(*latchPort, latchBit);
+	}
+	unsigned char counter = pwm.m_counter;
+
+	if(!noSPI){
+		//Use SPI to send out all bits
+		ShiftPWM_spiBegin();
+		if(fixedRegisters){
+			ShiftPWM_unrolled<fixedRegisters, false, invertOutputs, balanceLoad>::send(clockPort, dataPort, clockBit, dataBit, ledPtr, counter);
+		}
+		else if(viewport){
+			ShiftPWM_sendCircular<false, invertOutputs, balanceLoad>(clockPort, dataPort, clockBit, dataBit,
+			                      pwm.m_PWMValues, pwm.m_activeOutputs, &pwm.m_PWMValues[pwm.m_activeStart], pwm.m_activeRegisters, counter);
+		}
+		else if(pwm.m_binaryRegisters){
+			ShiftPWM_sendClasses<false, invertOutputs, balanceLoad>(clockPort, dataPort, clockBit, dataBit, pwm, ledPtr, counter);
+		}
+		else{
+			for(unsigned char i = pwm.m_activeRegisters; i>0;--i){   // do a whole shift register at once. This unrolls the loop for extra speed
+				ShiftPWM_sendRegisterSPI<invertOutputs, balanceLoad>(ledPtr, counter);
+			}
+		}
+		ShiftPWM_spiEnd();
+	}
+	else{
+		//Use port manipulation to send out all bits
+		if(fixedRegisters){
+			ShiftPWM_unrolled<fixedRegisters, true, invertOutputs, balanceLoad>::send(clockPort, dataPort, clockBit, dataBit, ledPtr, counter);
+		}
+		else if(viewport){
+			ShiftPWM_sendCircular<true, invertOutputs, balanceLoad>(clockPort, dataPort, clockBit, dataBit,
+			                      pwm.m_PWMValues, pwm.m_activeOutputs, &pwm.m_PWMValues[pwm.m_activeStart], pwm.m_activeRegisters, counter);
+		}
+		else if(pwm.m_binaryRegisters){
+			ShiftPWM_sendClasses<true, invertOutputs, balanceLoad>(clockPort, dataPort, clockBit, dataBit, pwm, ledPtr, counter);
+		}
+		else{
+			for(unsigned char i = pwm.m_activeRegisters; i>0;--i){   // do one shift register at a time. This unrolls the loop for extra speed
+				ShiftPWM_sendRegisterNoSPI<invertOutputs, balanceLoad>(clockPort, dataPort, clockBit, dataBit, ledPtr, counter);
+			}
+		}
+	}
+
+	// Write shift register latch clock high
+	if(!hardwareLatch){
+		bitSet(*latchPort, latchBit);
+	}
+
+	if(pwm.m_counter==0 && pwm.m_partialOutputs==0 && pwm.m_idleShutdown && (!balanceLoad || pwm.m_maxBrightness==255)){
+		// All outputs are fully on or off, so all steps are the same as the one that was just latched. Stop until a value
+		// changes, see CShiftPWM::SetIdleShutdown. The counter stays at 0. With balanceLoad, the shifted counters of the
+		// registers only give the same steps with 256 brightness levels.
+		pwm.EnterIdle();
+		return;
+	}
+
+	if(pwm.m_counter<pwm.m_maxBrightness){
+		pwm.m_counter++; // Increase the counter
+	}
+	else{
+		pwm.m_counter=0; // Reset counter if it maximum brightness has been reached
+		pwm.m_dutyIntegral += pwm.m_dutySum; // energy meter: each value was on for value interrupts of this period
+		pwm.m_frameCount++;
+		// A new amount of registers set by SetAmountOfRegisters and a new offset take effect at the start of a new period,
+		// so the outputs do not tear
+		pwm.StartPeriod();
+		if(pwm.m_frameCallback){
+			pwm.m_frameCallback(); // see CShiftPWM::SetFrameCallback
+		}
+	}
+}
+
+#endif
+
+// Ways to select the active row of a matrix. See CShiftPWMMatrix.h.
+enum ShiftPWM_rowDriver{
+	ShiftPWM_rowShiftRegister = 0,	// a separate row shift register on rowLatchPin, rowDataPin and rowClockPin
+	ShiftPWM_rowSPI,				// the row registers are connected after the last column register, and sent with the columns
+	ShiftPWM_rowDecoder3,			// a 74HC138 decoder, with its 3 address lines on rowDataPin and the next 2 bits of the same port
+	ShiftPWM_rowDecoder4			// a 74HC154 decoder, with its 4 address lines on rowDataPin and the next 3 bits of the same port
+};
+
+#if defined(__AVR__)
+// Sets the compare value of the timer from the interrupt, for bit angle modulation. The registers are the same as in
+// CShiftPWM::SetTimerCompareValue, but the timer is a compile time constant. The timer was cleared by the compare match
+// that started the interrupt, so it is still below the new value.
+template<int timer>
+static inline void ShiftPWM_setTimerCompare(unsigned int compareValue) __attribute__((always_inline));
+template<int timer>
+static inline void ShiftPWM_setTimerCompare(unsigned int compareValue){
+	if(timer==1){
+		#if defined(SHIFTPWM_TINY_TIMER1)
+		OCR1C = compareValue;
+		#endif
+		OCR1A = compareValue;
+	}
+	#if defined(OCR2A)
+	else if(timer==2){
+		OCR2A = compareValue;
+	}
+	#endif
+	#if defined(OCR3A)
+	else if(timer==3){
+		OCR3A = compareValue;
+	}
+	#endif
+	#if defined(TC4H)
+	else if(timer==4){
+		TC4H = compareValue>>8;
+		OCR4C = compareValue & 0xFF;
+		TC4H = compareValue>>8;
+		OCR4A = compareValue & 0xFF;
+	}
+	#elif defined(OCR4A)
+	else if(timer==4){
+		OCR4A = compareValue;
+	}
+	#endif
+	#if defined(OCR5A)
+	else if(timer==5){
+		OCR5A = compareValue;
+	}
+	#endif
+}
+
+// Interrupt for a multiplexed matrix: the column registers are sent like a normal chain, but only one row is on at a time.
+// Each row gets maxBrightness+1 interrupts, then the next row is selected.
+// With a row shift register, the row register is clocked before the columns are sent, but not latched. The column and row latches
+// are then set directly after each other, so the new row switches on with its own data and no blank period is needed between rows.
+// With rowSPI, the row bytes are sent in the same transfer as the columns and latched by the same latch pulse.
+// With a decoder, the row address is written to the port directly after the column latch, which is a single port write.
+// The row and column offset of CShiftPWMMatrix::SetViewport are applied here: m_rowStart is the first value of the row that
+// is shown, and the columns are read as a circular buffer from m_activeStart.
+// With an output enable pin (columnOEPin is not -1), the columns are switched off at the start of the first interrupt of a row,
+// and switched on again after the new column data and the new row are latched. The row registers or the decoder then never
+// switch while the columns are on.
+// With bit angle modulation (see CShiftPWMMatrix::StartBAM), each row gets one interrupt per bit instead of maxBrightness+1.
+// The counter is the number of the bit, the outputs are on when their value has the bit of m_bamMask set, and the compare value
+// of the timer is set so the bit is shown for m_bamTicks timer clocks. Each row starts with the most significant bit.
+template<int latchPin, int dataPin, int clockPin, bool noSPI, bool invertColumns, bool balanceLoad,
+         int rowLatchPin, int rowDataPin, int rowClockPin, bool invertRows, int rowDriver, int columnOEPin, int timer>
+static inline void ShiftPWM_handleInterrupt_matrix(CShiftPWM & pwm){
+	if(pwm.m_bamBits){
+		// Done before interrupts are enabled, because a 16 bit register is written through the temporary high byte register
+		ShiftPWM_setTimerCompare<timer>(pwm.m_bamTicks-1);
+	}
+	sei(); //enable interrupt nesting to prevent disturbing other interrupt functions (servo's for example).
+
+	volatile uint8_t * const latchPort = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[latchPin]];
+	const uint8_t latchBit =  digital_pin_to_bit_PGM_ct[latchPin];
+
+	volatile uint8_t * const clockPort = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[clockPin]];
+	volatile uint8_t * const dataPort  = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[dataPin]];
+	const uint8_t clockBit =  digital_pin_to_bit_PGM_ct[clockPin];
+	const uint8_t dataBit =   digital_pin_to_bit_PGM_ct[dataPin];
+
+	volatile uint8_t * const rowLatchPort = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[rowLatchPin]];
+	volatile uint8_t * const rowClockPort = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[rowClockPin]];
+	volatile uint8_t * const rowDataPort  = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[rowDataPin]];
+	const uint8_t rowLatchBit =  digital_pin_to_bit_PGM_ct[rowLatchPin];
+	const uint8_t rowClockBit =  digital_pin_to_bit_PGM_ct[rowClockPin];
+	const uint8_t rowDataBit =   digital_pin_to_bit_PGM_ct[rowDataPin];
+
+	// The latch pin is looked up instead when there is no output enable pin, so the index is always valid
+	volatile uint8_t * const columnOEPort = port_to_output_PGM_ct[digital_pin_to_port_PGM_ct[(columnOEPin>=0) ? columnOEPin : latchPin]];
+	const uint8_t columnOEBit =  digital_pin_to_bit_PGM_ct[(columnOEPin>=0) ? columnOEPin : latchPin];
+
+	unsigned char counter = pwm.m_counter;
+	const bool newRow = (counter==0);
+	const unsigned char row = pwm.m_currentRow;
+
+	if(columnOEPin>=0 && newRow){
+		bitSet(*columnOEPort, columnOEBit); // output enable is active low: all columns off until the new row is latched
+	}
+
+	if(rowDriver==ShiftPWM_rowShiftRegister && newRow){
+		// Shift the row register by one. At the first row, a new 'on' bit is shifted in.
+		bitWrite(*rowDataPort, rowDataBit, (row==0) != invertRows);
+		bitClear(*rowClockPort, rowClockBit);
+		bitSet(*rowClockPort, rowClockBit);
+		bitClear(*rowLatchPort, rowLatchBit);
+	}
+
+	unsigned char * rowValues=&pwm.m_PWMValues[pwm.m_rowStart];
+	const int columns = pwm.m_activeRegisters*8;
+
+	bitClear(*latchPort, latchBit);
+	if(!noSPI){
+		ShiftPWM_spiBegin();
+		if(rowDriver==ShiftPWM_rowSPI){
+			// The row registers are at the end of the chain, so they are sent first. The last row register is sent first.
+			// The first bit of a register that is sent ends up at Q7, so row r is bit 7-r of its register (bit r if the port sends bit 7 first).
+			for(unsigned char k = (pwm.m_activeRows+7)>>3; k>0; --k){
+				unsigned char sendbyte = ((row>>3) == k-1) ? (ShiftPWM_spiMsbFirst ? (0x01<<(row&7)) : (0x80>>(row&7))) : 0;
+				if(invertRows){
+					sendbyte = ~sendbyte;
+				}
+				ShiftPWM_spiWrite(sendbyte);
+			}
+		}
+		if(pwm.m_bamBits){
+			unsigned char mask = pwm.m_bamMask;
+			ShiftPWM_sendCircular<false, invertColumns, false, true>(clockPort, dataPort, clockBit, dataBit,
+			                      rowValues, columns, &rowValues[pwm.m_activeStart], pwm.m_activeRegisters, mask);
+		}
+		else{
+			ShiftPWM_sendCircular<false, invertColumns, balanceLoad>(clockPort, dataPort, clockBit, dataBit,
+			                      rowValues, columns, &rowValues[pwm.m_activeStart], pwm.m_activeRegisters, counter);
+		}
+		ShiftPWM_spiEnd();
+	}
+	else{
+		if(rowDriver==ShiftPWM_rowSPI){
+			// Same as above, one bit at a time. Rows 7 to 0 of the last row register are sent first.
+			for(unsigned char k = ((pwm.m_activeRows+7)>>3)<<3; k>0; --k){
+				bitClear(*clockPort, clockBit);
+				bitWrite(*dataPort, dataBit, (row == k-1) != invertRows);
+				bitSet(*clockPort, clockBit);
+			}
+		}
+		if(pwm.m_bamBits){
+			unsigned char mask = pwm.m_bamMask;
+			ShiftPWM_sendCircular<true, invertColumns, false, true>(clockPort, dataPort, clockBit, dataBit,
+			                      rowValues, columns, &rowValues[pwm.m_activeStart], pwm.m_activeRegisters, mask);
+		}
+		else{
+			ShiftPWM_sendCircular<true, invertColumns, balanceLoad>(clockPort, dataPort, clockBit, dataBit,
+			                      rowValues, columns, &rowValues[pwm.m_activeStart], pwm.m_activeRegisters, counter);
+		}
+	}
+	bitSet(*latchPort, latchBit);
+	if(newRow){
+		if(rowDriver==ShiftPWM_rowShiftRegister){
+			bitSet(*rowLatchPort, rowLatchBit);
+		}
+		else if(rowDriver==ShiftPWM_rowDecoder3 || rowDriver==ShiftPWM_rowDecoder4){
+			// Write the row number to the address lines of the decoder. The other bits of the port are kept.
+			const uint8_t addressMask = ((rowDriver==ShiftPWM_rowDecoder3) ? 0x07 : 0x0F) << rowDataBit;
+			*rowDataPort = (*rowDataPort & ~addressMask) | ((row << rowDataBit) & addressMask);
+		}
+		if(columnOEPin>=0){
+			bitClear(*columnOEPort, columnOEBit);
+		}
+	}
+
+	const unsigned char lastStep = pwm.m_bamBits ? pwm.m_bamBits-1 : pwm.m_maxBrightness;
+	if(pwm.m_counter<lastStep){
+		pwm.m_counter++; // Increase the counter
+		if(pwm.m_bamBits){
+			pwm.m_bamMask >>= 1; // the next bit is shown half as long
+			pwm.m_bamTicks >>= 1;
+		}
+	}
+	else{
+		pwm.m_counter=0;
+		if(pwm.m_bamBits){
+			pwm.m_bamMask = (pwm.m_maxBrightness>>1)+1;
+			pwm.m_bamTicks = pwm.m_bamLongest;
+		}
+		if(pwm.m_currentRow+1 < pwm.m_activeRows){
+			pwm.m_currentRow++;
+			pwm.m_rowStart += columns;
+			if(pwm.m_rowStart >= pwm.m_activeOutputs){
+				pwm.m_rowStart = 0; // the row offset wraps around to the first row
+			}
+		}
+		else{
+			// A new matrix size set by SetMatrixSize or SetAmountOfRegisters takes effect at the start of a new frame,
+			// as well as a new viewport set by SetViewport.
+			pwm.m_dutyIntegral += pwm.m_dutySum; // energy meter: each value was on for value interrupts of this frame
+			pwm.m_currentRow=0;
+			pwm.m_activeRows = pwm.m_amountOfRows;
+			pwm.m_activeRegisters = pwm.m_amountOfRegisters;
+			pwm.m_activeOutputs = pwm.m_amountOfOutputs;
+			unsigned char viewRow = (pwm.m_viewRow < pwm.m_activeRows) ? pwm.m_viewRow : 0;
+			pwm.m_rowStart = viewRow*pwm.m_activeRegisters*8;
+			pwm.m_activeStart = (pwm.m_viewStart <= pwm.m_activeRegisters*8) ? pwm.m_viewStart : pwm.m_activeRegisters*8;
+			if(pwm.m_swapPending){
+				// Show the frame that was drawn in the back buffer. Swapping between frames prevents tearing.
+				unsigned char * front = pwm.m_PWMValues;
+				pwm.m_PWMValues = pwm.m_backValues;
+				pwm.m_backValues = front;
+				pwm.m_swapPending = false;
+			}
+			pwm.m_frameCount++;
+			if(pwm.m_frameCallback){
+				pwm.m_frameCallback(); // see CShiftPWM::SetFrameCallback
+			}
+		}
+	}
+}
+
+#endif
+
+// #endif for include once.
+#endif
@@ -0,0 +1,92 @@
+/*
+ShiftPWM_isr.h - Library for Arduino to PWM many outputs using shift registers
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+SHIFTPWM_DEFINE(settings, timer) defines the ShiftPWM object and installs its interrupt, with the settings of a type.
+Use it in exactly one file. The settings type can be in a header that all files share, so they all see the same constants:
+
+	// LedSettings.h
+	#include <ShiftPWM_api.h>
+	struct LedSettings : ShiftPWM_defaultSettings{
+		static constexpr int latchPin = 8;
+		static constexpr bool invertOutputs = true;
+	};
+
+	// leds.cpp, the only file that includes ShiftPWM_isr.h
+	#include "LedSettings.h"
+	#include <ShiftPWM_isr.h>
+	SHIFTPWM_DEFINE(LedSettings, 1)
+
+	// any other file
+	#include "LedSettings.h"
+	void setup(){ ShiftPWM_start<LedSettings, 75, 255, 6>(); }
+
+The interrupt is generated in that one file, with the pins as template parameters (see ShiftPWM_core.h), so it writes
+them with single sbi and cbi instructions just like with ShiftPWM.h. The other files call the functions of the object,
+which are compiled in CShiftPWM.cpp anyway. The timer number has to be a literal, because it is pasted into the name
+of the interrupt vector. It is checked against the timer of the settings.
+*/
+
+#ifndef ShiftPWM_isr_h
+#define ShiftPWM_isr_h
+
+#include "pins_arduino_compile_time.h" // My own version of pins arduino, which does not define the arrays in program memory
+#include <Arduino.h>
+#include "ShiftPWM_api.h"
+#include "ShiftPWM_core.h"
+
+// Static buffer for settings::maxRegisters, or no buffer (heap) for 0. A static member of a template is defined only once.
+template<unsigned char maxRegisters>
+struct ShiftPWM_staticBuffer{
+	static unsigned char values[maxRegisters*8];
+};
+template<unsigned char maxRegisters>
+unsigned char ShiftPWM_staticBuffer<maxRegisters>::values[maxRegisters*8];
+
+template<>
+struct ShiftPWM_staticBuffer<0>{
+	static constexpr unsigned char * values = 0;
+};
+
+// The data and clock pin of the settings: the pins of the settings with noSPI, otherwise the SPI pins (DO and USCK on the ATtiny).
+template<class settings>
+struct ShiftPWM_pinsOf{
+	static constexpr int dataPin = settings::noSPI ? settings::dataPin : ShiftPWM_spiDataPin;
+	static constexpr int clockPin = settings::noSPI ? settings::clockPin : ShiftPWM_spiClockPin;
+};
+
+template<class settings>
+static inline void ShiftPWM_handleInterrupt_settings(CShiftPWM & pwm){
+	static_assert(settings::latchPin >= 0, "ShiftPWM: set latchPin in the settings");
+	static_assert(!settings::noSPI || (settings::dataPin >= 0 && settings::clockPin >= 0), "ShiftPWM: set dataPin and clockPin in the settings for noSPI");
+	ShiftPWM_handleInterrupt_core<settings::latchPin, ShiftPWM_pinsOf<settings>::dataPin, ShiftPWM_pinsOf<settings>::clockPin, settings::noSPI,
+	                              settings::invertOutputs, settings::balanceLoad, settings::hardwareLatch, 0, settings::viewport>(pwm);
+}
+
+#define SHIFTPWM_DEFINE(settings, timerNumber) \
+	CShiftPWM ShiftPWM(timerNumber, settings::noSPI, settings::latchPin, ShiftPWM_pinsOf<settings>::dataPin, ShiftPWM_pinsOf<settings>::clockPin, \
+	                   ShiftPWM_staticBuffer<settings::maxRegisters>::values, settings::maxRegisters, settings::hardwareLatch); \
+	ISR(TIMER##timerNumber##_COMPA_vect) { \
+		static_assert(timerNumber == settings::timer, "Timer of SHIFTPWM_DEFINE does not match the timer of the settings"); \
+		ShiftPWM_handleInterrupt_settings<settings>(ShiftPWM); \
+	}
+
+// #endif for include once.
+#endif
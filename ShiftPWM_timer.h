@@ -0,0 +1,145 @@
+/*
+ShiftPWM_timer.h - Library for Arduino to PWM many outputs using shift registers
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Timer settings, calculated with integers only. CShiftPWM::Start uses these functions at runtime, so the library does not
+need the floating point routines of the compiler. They are constexpr, so with a constant frequency and number of brightness
+levels the same calculation is done by the compiler. The Start<...>() functions of the chains, the matrix and ShiftPWM.h
+use this to stop the build when the timer cannot run at the frequency or when the interrupt load would be too high:
+
+	stripA.Start<75, 255, 6>(); // 75 Hz, 256 brightness levels, 6 registers. Does not compile if it cannot work.
+
+The interrupt runs at ledFrequency*(maxBrightness+1)*rows. The timer counts compareValue+1 clocks of timerClock/prescaler
+between two interrupts, so compareValue = timerClock/(prescaler*interruptFrequency)-1, rounded to the nearest integer.
+The smallest prescaler for which compareValue fits in the timer is used, which gives the finest steps.
+*/
+
+#ifndef ShiftPWM_timer_h
+#define ShiftPWM_timer_h
+
+// Timer1 of the ATtiny25/45/85 is an 8 bit timer with its own registers: TCCR1 instead of TCCR1A and B, OCR1C as TOP,
+// and a prescaler that divides by 2^(clockSelect-1) like timer4 of the 32u4. See CShiftPWM::InitTimer1.
+#if defined(TCCR1) && !defined(TCCR1A)
+#define SHIFTPWM_TINY_TIMER1
+#endif
+
+// Division factor of clock select value clockSelect (CSn2:0 bits) of the timer, or 0 if the timer has no such clock select value.
+// Timer2 has 7 prescalers, the 16 bit timers have 5. Timer4 of the 32u4 and timer1 of the ATtiny85 divide by 2^(clockSelect-1), up to 16384.
+constexpr unsigned int ShiftPWM_timerPrescaler(int timer, unsigned char clockSelect){
+	return (clockSelect==0) ? 0 :
+	#if defined(TC4H)
+	       (timer==4) ? ((clockSelect<=15) ? (1u << (clockSelect-1)) : 0) :
+	#endif
+	#if defined(SHIFTPWM_TINY_TIMER1)
+	       (timer==1) ? ((clockSelect<=15) ? (1u << (clockSelect-1)) : 0) :
+	#endif
+	       (timer==2) ? ((clockSelect==1) ? 1 : (clockSelect==2) ? 8 : (clockSelect==3) ? 32 : (clockSelect==4) ? 64 :
+	                     (clockSelect==5) ? 128 : (clockSelect==6) ? 256 : (clockSelect==7) ? 1024 : 0) :
+	       ((clockSelect==1) ? 1 : (clockSelect==2) ? 8 : (clockSelect==3) ? 64 : (clockSelect==4) ? 256 : (clockSelect==5) ? 1024 : 0);
+}
+
+// Largest compare value of the timer: 8 bit timer2 (and timer1 of the ATtiny85), 10 bit timer4 of the 32u4, or a 16 bit timer
+constexpr unsigned long ShiftPWM_timerMaxCompare(int timer){
+	return (timer==2) ? 255 :
+	#if defined(SHIFTPWM_TINY_TIMER1)
+	       (timer==1) ? 255 :
+	#endif
+	#if defined(TC4H)
+	       (timer==4) ? 1023 :
+	#endif
+	       65535;
+}
+
+// Rounded compare value for the interrupt frequency, or 0 if the interrupt would be faster than the prescaled timer clock.
+// prescaler*interruptFrequency has to fit in 32 bits, which it does for every prescaler that ShiftPWM_timerClockSelect tries.
+constexpr unsigned long ShiftPWM_timerCompare(unsigned long timerClock, unsigned long interruptFrequency, unsigned int prescaler){
+	return (prescaler==0 || interruptFrequency==0 || (unsigned long) prescaler*interruptFrequency > timerClock) ? 0 :
+	       (timerClock + ((unsigned long) prescaler*interruptFrequency)/2)/((unsigned long) prescaler*interruptFrequency) - 1;
+}
+
+// Smallest clock select value for which the compare value fits in the timer, or 0 if the frequency is too low for the timer.
+constexpr unsigned char ShiftPWM_timerClockSelect(int timer, unsigned long timerClock, unsigned long interruptFrequency, unsigned char clockSelect = 1){
+	return (ShiftPWM_timerPrescaler(timer, clockSelect)==0) ? 0 :
+	       (ShiftPWM_timerCompare(timerClock, interruptFrequency, ShiftPWM_timerPrescaler(timer, clockSelect)) <= ShiftPWM_timerMaxCompare(timer)) ? clockSelect :
+	       ShiftPWM_timerClockSelect(timer, timerClock, interruptFrequency, clockSelect+1);
+}
+
+// Bit angle modulation (see CShiftPWMMatrix::StartBAM) shows bit n of the values for 2^n time units. unitFrequency is the rate of
+// one time unit, ledFrequency*maxBrightness*rows, and compareValue+1 is the length of one time unit in timer clocks.
+// The interrupt sets the compare value of each bit, so the longest bit, 2^(bits-1) time units, also has to fit in the timer.
+// Returns the smallest clock select value for which it fits, or 0 if the frequency is too low for the timer.
+constexpr unsigned char ShiftPWM_bamClockSelect(int timer, unsigned long timerClock, unsigned long unitFrequency, unsigned char bits, unsigned char clockSelect = 1){
+	return (ShiftPWM_timerPrescaler(timer, clockSelect)==0) ? 0 :
+	       ((ShiftPWM_timerCompare(timerClock, unitFrequency, ShiftPWM_timerPrescaler(timer, clockSelect))+1) << (bits-1) <= ShiftPWM_timerMaxCompare(timer)) ? clockSelect :
+	       ShiftPWM_bamClockSelect(timer, timerClock, unitFrequency, bits, clockSelect+1);
+}
+
+// Estimated duration of the interrupt in clock cycles, with inverted outputs, which is worst case.
+// Without inverting, it would be 42 per register with SPI.
+// A binary register (see CShiftPWM::SetRegisterClasses) is not calculated, its byte is sent as it is. With SPI it still
+// takes the 32 cycles that the SPI port needs to send a byte.
+constexpr unsigned long ShiftPWM_interruptCycles(bool noSPI, unsigned int amountOfRegisters, unsigned int binaryRegisters = 0){
+	return noSPI ? 96+108*(unsigned long) amountOfRegisters+64*(unsigned long) binaryRegisters :
+	               97+43*(unsigned long) amountOfRegisters+36*(unsigned long) binaryRegisters;
+}
+
+// The matrix interrupt with bit angle modulation masks each value before the compare, which is one instruction more per output,
+// and sets the compare value of the timer and the mask for the next bit. This is an estimate as well.
+constexpr unsigned long ShiftPWM_bamInterruptCycles(bool noSPI, unsigned int amountOfRegisters){
+	return ShiftPWM_interruptCycles(noSPI, amountOfRegisters)+8*(unsigned long) amountOfRegisters+20;
+}
+
+// True if the interrupt load (interruptCycles*interruptFrequency/cpuClock) is at most 0.9, without multiplying large numbers.
+constexpr bool ShiftPWM_loadNotTooHigh(unsigned long interruptCycles, unsigned long interruptFrequency, unsigned long cpuClock){
+	return interruptFrequency==0 || interruptCycles <= (cpuClock/10*9)/interruptFrequency;
+}
+
+#if defined(__AVR__)
+// Clock of the timer before the prescaler. Timer4 of the 32u4 is clocked by the PLL at 48 MHz, see CShiftPWM::InitTimer4.
+constexpr unsigned long ShiftPWM_timerClock(int timer){
+	#if defined(TC4H)
+	return (timer==4) ? 48000000UL : F_CPU;
+	#else
+	return F_CPU;
+	#endif
+}
+
+// Stops the build if a configuration cannot work. Called by the Start<...>() functions, it generates no code.
+template<int timer, bool noSPI, int ledFrequency, unsigned char maxBrightness, unsigned int amountOfRegisters, unsigned char amountOfRows = 1>
+inline void ShiftPWM_checkTimerSettings(void){
+	static_assert(ShiftPWM_timerClockSelect(timer, ShiftPWM_timerClock(timer), (unsigned long) ledFrequency*(maxBrightness+1)*amountOfRows) != 0,
+	              "ShiftPWM: the frequency is too low for this timer, even with the largest prescaler");
+	static_assert(ShiftPWM_loadNotTooHigh(ShiftPWM_interruptCycles(noSPI, amountOfRegisters), (unsigned long) ledFrequency*(maxBrightness+1)*amountOfRows, F_CPU),
+	              "ShiftPWM: the interrupt load would be higher than 0.9. Use a lower frequency, fewer brightness levels or fewer registers");
+}
+
+// Same for bit angle modulation, called by CShiftPWMMatrix::StartBAM<...>(). The interrupt has to fit in the shortest bit.
+template<int timer, bool noSPI, int ledFrequency, unsigned char bits, unsigned int amountOfRegisters, unsigned char amountOfRows>
+inline void ShiftPWM_checkBAMSettings(void){
+	static_assert(bits>=1 && bits<=8, "ShiftPWM: bit angle modulation needs 1 to 8 bits");
+	static_assert(ShiftPWM_bamClockSelect(timer, ShiftPWM_timerClock(timer), (unsigned long) ledFrequency*((1u<<bits)-1)*amountOfRows, bits) != 0,
+	              "ShiftPWM: the frequency is too low for this timer, even with the largest prescaler");
+	static_assert(ShiftPWM_loadNotTooHigh(ShiftPWM_bamInterruptCycles(noSPI, amountOfRegisters), (unsigned long) ledFrequency*((1u<<bits)-1)*amountOfRows, F_CPU),
+	              "ShiftPWM: the shortest bit would be shorter than the interrupt. Use a lower frequency, fewer bits or fewer registers");
+}
+#endif
+
+// #endif for include once.
+#endif
@@ -0,0 +1,44 @@
+/*
+ * ShiftPWM ATtiny example, (c) Elco Jacobs.
+ *
+ * The ATtiny25/45/85 and ATtiny24/44/84 have no SPI port. ShiftPWM uses their USI in three-wire mode instead,
+ * which the interrupt clocks by writing USICR: a byte takes 17 clock cycles.
+ * Connect the data input of the first shift register to DO and the clock input to USCK:
+ *   ATtiny85: DO is pin 1 (PB1), USCK is pin 2 (PB2).
+ *   ATtiny84: DO is pin 5 (PA5), USCK is pin 4 (PA4), with the counterclockwise pin numbering.
+ * Timer1 generates the interrupt. On the ATtiny85 it is an 8 bit timer, which limits the lowest frequency.
+ *
+ * Please go to www.elcojacobs.com/shiftpwm for documentation, fuction reference and schematics.
+ */
+
+// Clock and data pins are DO and USCK of the USI, see above.
+const int ShiftPWM_latchPin=3;
+
+const bool ShiftPWM_invertOutputs = false;
+const bool ShiftPWM_balanceLoad = false;
+
+#include <ShiftPWM.h>   // include ShiftPWM.h after setting the pins!
+
+// Two registers, 60 Hz and 32 brightness levels: an 8 MHz ATtiny has little time left for loop with more.
+const unsigned char numRegisters = 2;
+const unsigned char maxBrightness = 31;
+
+void setup(){
+  // This does not compile if the interrupt load would be too high.
+  ShiftPWM_start<60, maxBrightness, numRegisters>();
+}
+
+void loop()
+{
+  // Fade each output in and out in turn
+  for(unsigned char output = 0; output < numRegisters*8; output++){
+    for(int brightness = 0; brightness <= maxBrightness; brightness++){
+      ShiftPWM.SetOne(output, brightness);
+      delay(10);
+    }
+    for(int brightness = maxBrightness; brightness >= 0; brightness--){
+      ShiftPWM.SetOne(output, brightness);
+      delay(10);
+    }
+  }
+}
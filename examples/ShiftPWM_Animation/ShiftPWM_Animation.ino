@@ -0,0 +1,58 @@
+/*
+ * ShiftPWM animation example, (c) Elco Jacobs.
+ *
+ * This example plays a show from program memory with CShiftPWMAnimation.
+ * show.h was made from comet.txt with the encoder in the tools directory of the library. Build it in the library
+ * directory and run it in the directory of this example:
+ *   g++ -O2 tools/ShiftPWM_encode_animation.cpp -o encode_animation
+ *   cd examples/ShiftPWM_Animation
+ *   ../../encode_animation comet.txt show.h -name show -periods 4 -loop 0
+ * Each line of comet.txt is one frame. With -periods 4, each frame is shown for 4 PWM periods.
+ *
+ * Send '+' or '-' over the serial port to play the show faster or slower.
+ *
+ * Please go to www.elcojacobs.com/shiftpwm for documentation, fuction reference and schematics.
+ */
+
+// You can choose the latch pin yourself.
+const int ShiftPWM_latchPin=8;
+
+const bool ShiftPWM_invertOutputs = false;
+const bool ShiftPWM_balanceLoad = false;
+
+#include <ShiftPWM.h>   // include ShiftPWM.h after setting the pins!
+#include <CShiftPWMAnimation.h>
+#include "show.h"
+
+unsigned char maxBrightness = 255;
+unsigned char pwmFrequency = 75;
+unsigned int numRegisters = 3; // the show has 24 outputs
+
+CShiftPWMAnimation player(ShiftPWM);
+unsigned int tempo = 256; // normal speed
+
+void setup(){
+  Serial.begin(9600);
+
+  ShiftPWM.SetAmountOfRegisters(numRegisters);
+  ShiftPWM.Start(pwmFrequency,maxBrightness);
+
+  player.Play(show); // loops forever
+}
+
+void loop()
+{
+  player.Update(); // shows a new frame when it is due
+
+  if(Serial.available()){
+    char c = Serial.read();
+    if(c=='+' && tempo<2048){
+      tempo *= 2;
+    }
+    else if(c=='-' && tempo>32){
+      tempo /= 2;
+    }
+    player.SetTempo(tempo);
+    Serial.print(F("Tempo: ")); Serial.println(tempo);
+  }
+}
@@ -0,0 +1,20 @@
+// Made with ShiftPWM_encode_animation from comet.txt. Play it with CShiftPWMAnimation.
+// Regenerate with tools/ShiftPWM_encode_animation.cpp, in the directory it was made in:
+//	encode_animation comet.txt show.h -name show -periods 4 -loop 0
+// 40 frames of 24 outputs, 272 bytes (960 uncompressed)
+const unsigned char show[] PROGMEM = {
+	24,0,40,0,0,0,9,0,4,128,255,214,0,0,129,128,255,0,130,64,
+	128,255,0,131,32,64,128,255,0,132,16,32,64,128,255,0,133,8,16,32,
+	64,128,255,0,134,0,8,16,32,64,128,255,0,1,134,0,8,16,32,64,
+	128,255,0,2,134,0,8,16,32,64,128,255,0,3,134,0,8,16,32,64,
+	128,255,0,4,134,0,8,16,32,64,128,255,0,5,134,0,8,16,32,64,
+	128,255,0,6,134,0,8,16,32,64,128,255,0,7,134,0,8,16,32,64,
+	128,255,0,8,134,0,8,16,32,64,128,255,0,9,134,0,8,16,32,64,
+	128,255,0,10,134,0,8,16,32,64,128,255,0,11,134,0,8,16,32,64,
+	128,255,0,12,134,0,8,16,32,64,128,255,0,13,134,0,8,16,32,64,
+	128,255,0,14,134,0,8,16,32,64,128,255,0,15,134,0,8,16,32,64,
+	128,255,0,16,134,0,8,16,32,64,128,255,0,17,134,0,8,16,32,64,
+	128,255,0,18,197,0,0,215,32,0,215,64,0,215,96,0,215,128,0,215,
+	160,0,215,192,0,215,224,0,215,255,0,215,223,0,215,191,0,215,159,0,
+	215,127,0,215,95,0,215,63,0,215,31,0
+};
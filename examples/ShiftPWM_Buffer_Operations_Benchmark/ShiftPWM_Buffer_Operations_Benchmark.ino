@@ -0,0 +1,95 @@
+/*
+ * ShiftPWM buffer operations benchmark, (c) Elco Jacobs.
+ *
+ * This example measures how long it takes to change all outputs at once with the buffer operations
+ * (ScaleAll, AddBuffer, BlendBuffers, MaxBuffer and MinBuffer), compared to calling SetOne for each output.
+ * The times include the time spent in the ShiftPWM interrupt, like in a real program.
+ * A scene transition is smooth when one step of it takes less than one PWM period, which is also printed.
+ *
+ * 48 registers need 3 buffers of 384 bytes. On an Arduino Uno, that is more than half of the RAM.
+ *
+ * Please go to www.elcojacobs.com/shiftpwm for documentation, fuction reference and schematics.
+ */
+
+// You can choose the latch pin yourself.
+const int ShiftPWM_latchPin=8;
+
+const bool ShiftPWM_invertOutputs = false;
+const bool ShiftPWM_balanceLoad = false;
+
+#include <ShiftPWM.h>   // include ShiftPWM.h after setting the pins!
+
+unsigned char maxBrightness = 255;
+unsigned char pwmFrequency = 75;
+const unsigned int numRegisters = 48;
+const unsigned int numOutputs = numRegisters*8;
+
+// Two scenes to crossfade between
+unsigned char sceneA[numOutputs];
+unsigned char sceneB[numOutputs];
+
+void setup(){
+  Serial.begin(9600);
+
+  ShiftPWM.SetAmountOfRegisters(numRegisters);
+  ShiftPWM.Start(pwmFrequency,maxBrightness);
+
+  for(unsigned int k=0; k<numOutputs; k++){
+    sceneA[k] = k;
+    sceneB[k] = 255-k;
+  }
+}
+
+void printTime(const __FlashStringHelper * name, unsigned long time){
+  Serial.print(name);
+  Serial.print(time);
+  Serial.println(F(" us"));
+}
+
+void loop()
+{
+  unsigned long start;
+
+  Serial.print(F("One PWM period: ")); Serial.print(1000000UL/pwmFrequency); Serial.println(F(" us"));
+
+  start = micros();
+  for(unsigned int k=0; k<numOutputs; k++){
+    ShiftPWM.SetOne(k, ((unsigned int) sceneA[k]*128)>>8);
+  }
+  printTime(F("Scale with SetOne:     "), micros()-start);
+
+  ShiftPWM.BlendBuffers(sceneA, sceneA, 0); // start from scene A again
+  start = micros();
+  ShiftPWM.ScaleAll(127);
+  printTime(F("ScaleAll:              "), micros()-start);
+
+  start = micros();
+  for(unsigned int k=0; k<numOutputs; k++){
+    ShiftPWM.SetOne(k, sceneA[k] + (((int) sceneB[k]-sceneA[k])*128)/256);
+  }
+  printTime(F("Crossfade with SetOne: "), micros()-start);
+
+  start = micros();
+  ShiftPWM.BlendBuffers(sceneA, sceneB, 127);
+  printTime(F("BlendBuffers:          "), micros()-start);
+
+  start = micros();
+  ShiftPWM.AddBuffer(sceneA);
+  printTime(F("AddBuffer:             "), micros()-start);
+
+  start = micros();
+  ShiftPWM.MaxBuffer(sceneB);
+  printTime(F("MaxBuffer:             "), micros()-start);
+
+  start = micros();
+  ShiftPWM.MinBuffer(sceneA);
+  printTime(F("MinBuffer:             "), micros()-start);
+
+  // A crossfade of one second, with one BlendBuffers per PWM period
+  for(unsigned int step=0; step<pwmFrequency; step++){
+    ShiftPWM.WaitForFrame();
+    ShiftPWM.BlendBuffers(sceneA, sceneB, (step*255)/(pwmFrequency-1));
+  }
+  Serial.println();
+  delay(5000);
+}
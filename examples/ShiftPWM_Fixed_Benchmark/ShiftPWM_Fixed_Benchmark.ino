@@ -0,0 +1,53 @@
+/*
+ * ShiftPWM fixed chain benchmark, (c) Elco Jacobs.
+ *
+ * This example compares the interrupt load of a chain with a fixed number of registers (CShiftPWMFixedChain)
+ * to the generic chain (CShiftPWMChain), which reads the number of registers at runtime.
+ * Run it once as is, and once with the line '#define USE_FIXED_CHAIN' commented out.
+ * Compare the 'Clock cycles per interrupt' that is printed.
+ *
+ * Please go to www.elcojacobs.com/shiftpwm for documentation, fuction reference and schematics.
+ */
+
+#include <CShiftPWMChain.h>
+
+#define USE_FIXED_CHAIN
+
+const unsigned char numRegisters = 16;
+unsigned char maxBrightness = 255;
+unsigned char pwmFrequency = 75;
+
+#ifdef USE_FIXED_CHAIN
+//                  registers, timer, noSPI, latch, data, clock, invertOutputs, balanceLoad
+CShiftPWMFixedChain<numRegisters, 1, false, 8, MOSI, SCK, true, false> chain;
+#else
+//             timer, noSPI, latch, data, clock, invertOutputs, balanceLoad
+CShiftPWMChain<1, false, 8, MOSI, SCK, true, false> chain;
+#endif
+
+SHIFTPWM_CHAIN_ISR(1, chain)
+
+void setup(){
+  Serial.begin(9600);
+
+#ifndef USE_FIXED_CHAIN
+  chain.SetAmountOfRegisters(numRegisters);
+#endif
+  chain.Start(pwmFrequency, maxBrightness);
+
+  // Give all outputs a different value, so the compare results are not all the same.
+  for(int pin=0; pin<numRegisters*8; pin++){
+    chain.SetOne(pin, pin);
+  }
+}
+
+void loop()
+{
+#ifdef USE_FIXED_CHAIN
+  Serial.println(F("Fixed chain:"));
+#else
+  Serial.println(F("Generic chain:"));
+#endif
+  chain.PrintInterruptLoad();
+  delay(5000);
+}
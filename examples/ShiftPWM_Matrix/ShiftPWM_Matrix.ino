@@ -0,0 +1,71 @@
+/*
+ * ShiftPWM matrix example, (c) Elco Jacobs.
+ *
+ * This example drives a multiplexed LED matrix with CShiftPWMMatrix: 8 rows, selected by a row shift register,
+ * and 16 columns on 2 column shift registers. Only one row is on at a time.
+ * It replaces the example of the old ShiftMatrixPWM library. The schematic of a matrix driver board is in boards/LED Matrix.
+ *
+ * Please go to www.elcojacobs.com/shiftpwm for documentation, fuction reference and schematics.
+ */
+
+#include <CShiftPWMMatrix.h>
+
+// The column registers use the SPI port: data pin is MOSI (atmega168/328: pin 11. Mega: 51),
+// clock pin is SCK (atmega168/328: pin 13. Mega: 52). The row register uses normal pins.
+// Rows are inverted (active low), for PNP transistors.
+
+//                timer, noSPI, latch, data, clock, rowLatch, rowData, rowClock, invertColumns, invertRows
+CShiftPWMMatrix<1, false, 9, MOSI, SCK, 8, 6, 7, false, true> matrix;
+SHIFTPWM_CHAIN_ISR(1, matrix)
+
+const unsigned char maxBrightness = 63;
+const unsigned char refreshRate = 75;
+const int numRows = 8;
+const int numColumnRegisters = 2;
+const int numColumns = numColumnRegisters*8;
+
+void setup(){
+  Serial.begin(9600);
+
+  matrix.SetMatrixSize(numRows, numColumnRegisters);
+  matrix.Start(refreshRate, maxBrightness);
+  // Or use bit angle modulation: 6 interrupts per row instead of 64, for the same 64 brightness levels.
+  // matrix.StartBAM(refreshRate, 6);
+}
+
+void loop()
+{
+  // Print information about the interrupt frequency, duration and load on your program
+  matrix.SetAll(0);
+  matrix.PrintInterruptLoad();
+
+  // Fade in and fade out all outputs one by one fast. Usefull for testing your circuit
+  matrix.OneByOneFast();
+
+  // Fade in and out 2 outputs at a time
+  for(int row=0;row<numRows;row++){
+    for(int col=0;col<numColumns-1;col++){
+      matrix.SetAll(0);
+      for(int brightness=0;brightness<maxBrightness;brightness++){
+        matrix.SetOne(row, col+1, brightness);
+        matrix.SetOne(row, col, maxBrightness-brightness);
+        delay(10);
+      }
+    }
+  }
+
+  // A rainbow over all RGB leds, drawn in a back buffer. Each frame is shown completely, without tearing.
+  // Each row has numColumns/3 RGB leds.
+  if(matrix.EnableDoubleBuffer()){
+    for(int hue=0; hue<360; hue++){
+      for(int row=0; row<numRows; row++){
+        for(int led=0; led<numColumns/3; led++){
+          matrix.SetPixelHSV(row, led, (hue+(row+led)*20)%360, 255, 255);
+        }
+      }
+      matrix.SwapBuffers(false); // the whole frame is redrawn, so the old frame does not have to be copied
+      delay(20);
+    }
+    matrix.DisableDoubleBuffer();
+  }
+}
@@ -0,0 +1,48 @@
+/*
+ * ShiftPWM multiple chains example, (c) Elco Jacobs.
+ *
+ * This example shows how to drive two independent chains of shift registers with CShiftPWMChain.
+ * Each chain has its own timer, pins, frequency and number of brightness levels.
+ * It is written for an Arduino Mega, which has timers 1 to 5 available.
+ *
+ * Please go to www.elcojacobs.com/shiftpwm for documentation, fuction reference and schematics.
+ */
+
+#include <CShiftPWMChain.h>
+
+// Only one chain can use the SPI port. The second chain uses normal pins (noSPI), which is 2.5x slower.
+// Data pin is MOSI (Mega: 51), clock pin is SCK (Mega: 52).
+
+//                    timer, noSPI, latch, data, clock, invertOutputs, balanceLoad
+CShiftPWMChain<1, false, 8, MOSI, SCK, false, false> stripA;
+CShiftPWMChain<3, true, 22, 23, 24, false, false> stripB;
+
+// Install an interrupt for each chain. The timer numbers should match the ones used above.
+SHIFTPWM_CHAIN_ISR(1, stripA)
+SHIFTPWM_CHAIN_ISR(3, stripB)
+
+void setup(){
+  Serial.begin(9600);
+
+  stripA.SetAmountOfRegisters(6);
+  stripA.Start(75, 255);
+
+  // The second chain uses fewer brightness levels, so it can run at a higher frequency.
+  stripB.SetAmountOfRegisters(3);
+  stripB.Start(200, 31);
+}
+
+void loop()
+{
+  // Hue shift chain A, while chain B runs a different pattern.
+  for(int hue = 0; hue<360; hue++){
+    stripA.SetAllHSV(hue, 255, 255);
+    stripB.SetAllHSV(359-hue, 255, 255);
+    delay(20);
+  }
+
+  stripA.PrintInterruptLoad();
+  stripB.PrintInterruptLoad();
+
+  stripB.OneByOneFast();
+}
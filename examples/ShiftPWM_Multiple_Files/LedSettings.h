@@ -0,0 +1,15 @@
+// The settings of the ShiftPWM object, shared by all files of the sketch.
+// Only the settings that differ from ShiftPWM_defaultSettings (see ShiftPWM_api.h) have to be given.
+
+#include <ShiftPWM_api.h>
+
+struct LedSettings : ShiftPWM_defaultSettings{
+  static constexpr int timer = 1;
+  static constexpr int latchPin = 8;
+  static constexpr bool invertOutputs = false; // true for common anode LEDs
+  static constexpr unsigned char maxRegisters = 6; // static buffer, instead of the heap
+};
+
+// Defined in effects.cpp
+void Rainbow(unsigned int hue);
+void Chase(unsigned char position);
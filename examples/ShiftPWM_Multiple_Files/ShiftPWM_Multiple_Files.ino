@@ -0,0 +1,37 @@
+/*
+ * ShiftPWM multiple files example, (c) Elco Jacobs.
+ *
+ * ShiftPWM.h defines the ShiftPWM object and its interrupt, so it can only be included in one file.
+ * This example splits a sketch over several files: the settings are a type in LedSettings.h,
+ * this file defines the object and the interrupt with SHIFTPWM_DEFINE, and effects.cpp uses the object
+ * through ShiftPWM_api.h. The interrupt is as fast as with ShiftPWM.h, because the pins are still constants.
+ *
+ * Please go to www.elcojacobs.com/shiftpwm for documentation, fuction reference and schematics.
+ */
+
+#include "LedSettings.h"
+#include <ShiftPWM_isr.h>
+
+// Define the ShiftPWM object and its interrupt. Do this in one file only.
+// The timer number has to match the timer of the settings.
+SHIFTPWM_DEFINE(LedSettings, 1)
+
+void setup(){
+  Serial.begin(9600);
+
+  // 6 registers, 75 Hz, 256 brightness levels. This does not compile if the interrupt load would be too high.
+  ShiftPWM_start<LedSettings, 75, 255, 6>();
+}
+
+void loop()
+{
+  for(unsigned int hue = 0; hue<360; hue++){
+    Rainbow(hue);
+    delay(20);
+  }
+  for(unsigned char position = 0; position<48; position++){
+    Chase(position);
+    delay(50);
+  }
+  ShiftPWM.PrintInterruptLoad();
+}
@@ -0,0 +1,13 @@
+// This file uses ShiftPWM, but does not define it. It only needs the API header (through LedSettings.h),
+// so it can be compiled separately from the interrupt.
+
+#include "LedSettings.h"
+
+void Rainbow(unsigned int hue){
+  ShiftPWM.SetAllHSV(hue % 360, 255, 255);
+}
+
+void Chase(unsigned char position){
+  ShiftPWM.SetAll(0);
+  ShiftPWM.SetOne(position % (ShiftPWM.m_amountOfRegisters*8), 255);
+}
@@ -12,6 +12,8 @@
 // ShiftPWM uses timer1 by default. To use a different timer, before '#include <ShiftPWM.h>', add
 // #define SHIFTPWM_USE_TIMER2  // for Arduino Uno and earlier (Atmega328)
 // #define SHIFTPWM_USE_TIMER3  // for Arduino Micro/Leonardo (Atmega32u4)
+// #define SHIFTPWM_USE_TIMER4  // Micro/Leonardo: high speed timer on the 48 MHz PLL. Mega: 16 bit timer, like timer5
+// #define SHIFTPWM_USE_TIMER5  // for Arduino Mega (Atmega1280/2560)
 
 // Clock and data pins are pins from the hardware SPI, you cannot choose them yourself.
 // Data pin is MOSI (Uno and earlier: 11, Leonardo: ICSP 4, Mega: 51, Teensy 2.0: 2, Teensy 2.0++: 22) 
@@ -133,6 +135,9 @@ void loop()
       ; // flush remaining characters
     }
   }
+  if(!ShiftPWM.FrameStarted()){
+    return; // the LED's are only updated once per PWM period, more updates would never be shown
+  }
   switch(fadingMode){
   case 0:
     // Turn all LED's off.
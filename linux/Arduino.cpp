@@ -0,0 +1,81 @@
+/*
+Arduino.cpp for Linux - the part of the Arduino API that ShiftPWM uses, to compile CShiftPWM on Linux
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include <pthread.h>
+#include <time.h>
+
+ShiftPWM_linuxSREG SREG;
+ShiftPWM_linuxSerial Serial;
+
+static pthread_mutex_t interruptLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread bool interruptLockHeld = false; // by this thread
+
+void cli(void){
+	if(!interruptLockHeld){
+		pthread_mutex_lock(&interruptLock);
+		interruptLockHeld = true;
+	}
+}
+
+void sei(void){
+	if(interruptLockHeld){
+		interruptLockHeld = false;
+		pthread_mutex_unlock(&interruptLock);
+	}
+}
+
+ShiftPWM_linuxSREG::operator uint8_t() const{
+	return interruptLockHeld ? 0 : 0x80;
+}
+
+ShiftPWM_linuxSREG & ShiftPWM_linuxSREG::operator=(uint8_t value){
+	if(value & 0x80){
+		sei();
+	}
+	else{
+		cli();
+	}
+	return *this;
+}
+
+static unsigned long long monotonicMicros(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long) now.tv_sec*1000000 + now.tv_nsec/1000;
+}
+
+unsigned long millis(void){
+	return monotonicMicros()/1000;
+}
+
+unsigned long micros(void){
+	return monotonicMicros();
+}
+
+void delay(unsigned long ms){
+	struct timespec duration = { (time_t) (ms/1000), (long) (ms%1000)*1000000 };
+	while(nanosleep(&duration, &duration)!=0);
+}
+
+void delayMicroseconds(unsigned int us){
+	struct timespec duration = { (time_t) (us/1000000), (long) (us%1000000)*1000 };
+	while(nanosleep(&duration, &duration)!=0);
+}
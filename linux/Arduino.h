@@ -0,0 +1,107 @@
+/*
+Arduino.h for Linux - the part of the Arduino API that ShiftPWM uses, to compile CShiftPWM on Linux
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+This file is only used by the Linux backend (CShiftPWMLinux.h). Put the linux directory first on the include path,
+so CShiftPWM.cpp includes this file instead of the Arduino core. The Arduino IDE does not compile this directory.
+*/
+
+#ifndef ShiftPWM_linux_Arduino_h
+#define ShiftPWM_linux_Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+
+// There is no program memory, strings and tables are in normal memory.
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define memcpy_P memcpy
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(PSTR(string_literal)))
+
+#define _BV(bit) (1 << (bit))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) (bitvalue ? bitSet(value, bit) : bitClear(value, bit))
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define DEC 10
+#define HEX 16
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// The interrupt of the AVR is a thread on Linux. Disabling interrupts locks a mutex, which the thread also holds while it reads the values.
+// This way the code of CShiftPWM that disables interrupts works unchanged:
+//	uint8_t oldSREG = SREG; cli(); ... SREG = oldSREG;
+// SREG reads 0x80 (interrupts enabled) when the calling thread does not hold the lock. Writing a value with bit 7 set releases it.
+class ShiftPWM_linuxSREG{
+public:
+	operator uint8_t() const;
+	ShiftPWM_linuxSREG & operator=(uint8_t value);
+};
+extern ShiftPWM_linuxSREG SREG;
+void cli(void);
+void sei(void);
+
+// The pins are not used on Linux: the backend writes the SPI device and the latch GPIO itself.
+inline void pinMode(int, int){}
+inline void digitalWrite(int, int){}
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Serial prints to stdout
+class ShiftPWM_linuxSerial{
+public:
+	void print(const char * s){ fputs(s, stdout); }
+	void print(const __FlashStringHelper * s){ print(reinterpret_cast<const char *>(s)); }
+	void print(char c){ putchar(c); }
+	void print(unsigned char n, int base = DEC){ print((unsigned long) n, base); }
+	void print(int n, int base = DEC){ print((long) n, base); }
+	void print(unsigned int n, int base = DEC){ print((unsigned long) n, base); }
+	void print(long n, int base = DEC){
+		if(base==DEC){
+			printf("%ld", n);
+		}
+		else{
+			print((unsigned long) n, base);
+		}
+	}
+	void print(unsigned long n, int base = DEC){ printf((base==HEX) ? "%lX" : "%lu", n); }
+	void print(double n, int digits = 2){ printf("%.*f", digits, n); }
+
+	template<class T> void println(T value){ print(value); println(); }
+	template<class T> void println(T value, int format){ print(value, format); println(); }
+	void println(void){ print("\r\n"); }
+};
+extern ShiftPWM_linuxSerial Serial;
+
+#endif
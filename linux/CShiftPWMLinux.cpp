@@ -0,0 +1,465 @@
+/*
+CShiftPWMLinux.cpp - Library for Arduino to PWM many outputs using shift registers
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "CShiftPWMLinux.h"
+#include "ShiftPWM_core.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include <linux/gpio.h>
+
+// Calculates the bytes of all steps of a period, with the same function as the interrupt on the AVR.
+// With register classes, the binary registers are sent as their byte, like ShiftPWM_sendClasses. See CShiftPWM::SetRegisterClasses.
+template<bool invertOutputs, bool balanceLoad>
+static void ShiftPWM_calculateSteps(unsigned char * values, int outputs, unsigned char registers, unsigned int steps, unsigned char * out,
+                                    const char * classes, const unsigned char * binaryValues, unsigned char binaryRegisters){
+	for(unsigned int step=0; step<steps; step++){
+		unsigned char counter = step;
+		unsigned char * ledPtr = &values[outputs];
+		if(binaryRegisters){
+			const unsigned char * binaryPtr = &binaryValues[binaryRegisters];
+			for(unsigned char i = registers+binaryRegisters; i>0; --i){
+				if(classes[i-1]=='B'){
+					*out++ = invertOutputs ? ~*(--binaryPtr) : *(--binaryPtr);
+				}
+				else{
+					*out++ = ShiftPWM_registerByte<invertOutputs, balanceLoad>(ledPtr, counter);
+				}
+			}
+			continue;
+		}
+		for(unsigned char i = registers; i>0; --i){
+			*out++ = ShiftPWM_registerByte<invertOutputs, balanceLoad>(ledPtr, counter);
+		}
+	}
+}
+
+static void addNanoseconds(struct timespec & time, unsigned long long nanoseconds){
+	nanoseconds += time.tv_nsec;
+	time.tv_sec += nanoseconds/1000000000;
+	time.tv_nsec = nanoseconds%1000000000;
+}
+
+CShiftPWMLinux::CShiftPWMLinux(CShiftPWMLinuxIO & io, bool invertOutputs, bool balanceLoad, unsigned char * buffer, unsigned int maxRegisters) :
+					CShiftPWM(0, false, -1, -1, -1, buffer, maxRegisters), m_io(io), m_invertOutputs(invertOutputs), m_balanceLoad(balanceLoad){
+	m_threadStarted = false;
+	m_running = false;
+	m_stepLength = 0;
+	m_steps = 0;
+	m_stepNanoseconds = 0;
+	m_nextStep.tv_sec = 0;
+	m_nextStep.tv_nsec = 0;
+	m_lateSteps = 0;
+}
+
+CShiftPWMLinux::~CShiftPWMLinux(){
+	Stop();
+}
+
+bool CShiftPWMLinux::Start(int ledFrequency, unsigned char maxBrightness){
+	Stop();
+	CShiftPWM::Start(ledFrequency, maxBrightness);
+	if(!TimerInterruptEnabled() || ledFrequency<=0){
+		return false;
+	}
+	m_stepNanoseconds = 1000000000UL/((unsigned long) ledFrequency*(maxBrightness+1));
+	if(!m_io.Open()){
+		return false;
+	}
+
+	// Ask for real-time priority, so the steps are sent at regular intervals
+	m_running = true;
+	pthread_attr_t attributes;
+	struct sched_param priority;
+	priority.sched_priority = sched_get_priority_max(SCHED_FIFO)/2;
+	pthread_attr_init(&attributes);
+	pthread_attr_setinheritsched(&attributes, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attributes, SCHED_FIFO);
+	pthread_attr_setschedparam(&attributes, &priority);
+	int result = pthread_create(&m_thread, &attributes, Thread, this);
+	pthread_attr_destroy(&attributes);
+	if(result!=0){
+		// No permission for real-time priority, run at normal priority
+		result = pthread_create(&m_thread, 0, Thread, this);
+	}
+	if(result!=0){
+		m_running = false;
+		m_io.Close();
+		return false;
+	}
+	m_threadStarted = true;
+	return true;
+}
+
+void CShiftPWMLinux::Stop(void){
+	if(!m_threadStarted){
+		return;
+	}
+	m_running = false;
+	pthread_join(m_thread, 0);
+	m_threadStarted = false;
+	m_io.Close();
+}
+
+void CShiftPWMLinux::SendPeriod(void){
+	CalculatePeriod(false);
+	SendSteps(false);
+}
+
+unsigned long CShiftPWMLinux::GetLateSteps(void){
+	return m_lateSteps;
+}
+
+void * CShiftPWMLinux::Thread(void * object){
+	CShiftPWMLinux * pwm = (CShiftPWMLinux *) object;
+	clock_gettime(CLOCK_MONOTONIC, &pwm->m_nextStep);
+	while(pwm->m_running){
+		if(!pwm->TimerInterruptEnabled()){
+			delay(1);
+			clock_gettime(CLOCK_MONOTONIC, &pwm->m_nextStep);
+			continue;
+		}
+		if(pwm->CalculatePeriod(true)){
+			// All outputs are fully on or off: latch one step and wait until a value changes, see CShiftPWM::SetIdleShutdown
+			if(pwm->m_stepLength>0){
+				pwm->m_io.SendStep(&pwm->m_period[0], pwm->m_stepLength);
+			}
+			continue;
+		}
+		pwm->SendSteps(true);
+	}
+	return 0;
+}
+
+bool CShiftPWMLinux::CalculatePeriod(bool mayIdle){
+	// Returns true if the thread should stop after the first step, like the idle shutdown of the interrupt on the AVR.
+	// That is decided while the values are locked, so a value that changes right after it starts the thread again.
+	uint8_t oldSREG = SREG;
+	cli(); // the values cannot change while they are read, like in the interrupt on the AVR
+	// A new amount of registers set by SetAmountOfRegisters and a new offset take effect at the start of a new period
+	StartPeriod();
+	m_dutyIntegral += m_dutySum; // energy meter, see CShiftPWM::GetOnTime
+	m_frameCount++;
+	m_stepLength = m_activeRegisters + m_binaryRegisters;
+	m_steps = (unsigned int) m_maxBrightness+1;
+	m_period.resize(m_stepLength*m_steps);
+	unsigned char * values = m_PWMValues;
+	if(m_activeStart!=0 && m_activeStart<m_activeOutputs){
+		// Output k shows the value of output k+offset, like the viewport of the interrupt on the AVR. See CShiftPWM::SetOffset.
+		m_rotated.resize(m_activeOutputs);
+		for(int k=0; k<m_activeOutputs; k++){
+			m_rotated[k] = m_PWMValues[(k+m_activeStart)%m_activeOutputs];
+		}
+		values = &m_rotated[0];
+	}
+	if(m_stepLength>0){
+		unsigned char * out = &m_period[0];
+		if(m_invertOutputs){
+			if(m_balanceLoad) ShiftPWM_calculateSteps<true, true>(values, m_activeOutputs, m_activeRegisters, m_steps, out, m_registerClasses, m_binaryValues, m_binaryRegisters);
+			else ShiftPWM_calculateSteps<true, false>(values, m_activeOutputs, m_activeRegisters, m_steps, out, m_registerClasses, m_binaryValues, m_binaryRegisters);
+		}
+		else{
+			if(m_balanceLoad) ShiftPWM_calculateSteps<false, true>(values, m_activeOutputs, m_activeRegisters, m_steps, out, m_registerClasses, m_binaryValues, m_binaryRegisters);
+			else ShiftPWM_calculateSteps<false, false>(values, m_activeOutputs, m_activeRegisters, m_steps, out, m_registerClasses, m_binaryValues, m_binaryRegisters);
+		}
+	}
+	bool idle = mayIdle && m_partialOutputs==0 && m_idleShutdown && (!m_balanceLoad || m_maxBrightness==255);
+	if(idle){
+		EnterIdle(); // all steps are the same, see the interrupt in ShiftPWM_core.h
+	}
+	SREG = oldSREG;
+	if(m_frameCallback){
+		m_frameCallback(); // see CShiftPWM::SetFrameCallback, called without the lock like the interrupt does on the AVR
+	}
+	return idle;
+}
+
+void CShiftPWMLinux::SendSteps(bool paced){
+	if(m_stepLength==0){
+		if(paced){
+			WaitForStep();
+			addNanoseconds(m_nextStep, (unsigned long long) m_stepNanoseconds*m_steps);
+		}
+		return;
+	}
+	if(m_io.BatchesPeriods()){
+		if(paced){
+			WaitForStep();
+			addNanoseconds(m_nextStep, (unsigned long long) m_stepNanoseconds*m_steps);
+		}
+		m_io.SendPeriod(&m_period[0], m_stepLength, m_steps, m_stepNanoseconds);
+		return;
+	}
+	for(unsigned int step=0; step<m_steps; step++){
+		if(paced){
+			WaitForStep();
+			addNanoseconds(m_nextStep, m_stepNanoseconds);
+		}
+		m_io.SendStep(&m_period[step*m_stepLength], m_stepLength);
+	}
+}
+
+void CShiftPWMLinux::WaitForStep(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	struct timespec late = m_nextStep;
+	addNanoseconds(late, m_stepNanoseconds);
+	if(now.tv_sec > late.tv_sec || (now.tv_sec==late.tv_sec && now.tv_nsec > late.tv_nsec)){
+		// More than a step late. Continue from now, instead of sending the missed steps as fast as possible.
+		m_lateSteps++;
+		m_nextStep = now;
+		return;
+	}
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &m_nextStep, 0)!=0);
+}
+
+
+static unsigned char reverseBits(unsigned char b){
+	b = (b & 0xF0)>>4 | (b & 0x0F)<<4;
+	b = (b & 0xCC)>>2 | (b & 0x33)<<2;
+	b = (b & 0xAA)>>1 | (b & 0x55)<<1;
+	return b;
+}
+
+CShiftPWMSpidev::CShiftPWMSpidev(const char * spiDevice, unsigned long speedHz, const char * gpioChip, int latchLine) :
+					m_spiDevice(spiDevice), m_speedHz(speedHz), m_gpioChip(gpioChip), m_latchLine(latchLine){
+	m_spiFd = -1;
+	m_latchFd = -1;
+	m_reverseBits = false;
+}
+
+CShiftPWMSpidev::~CShiftPWMSpidev(){
+	Close();
+}
+
+bool CShiftPWMSpidev::Open(void){
+	Close();
+	m_spiFd = open(m_spiDevice, O_RDWR);
+	if(m_spiFd<0){
+		return false;
+	}
+	// The shift registers read the data on the rising edge of the clock, like SPI mode 0
+	uint8_t mode = SPI_MODE_0;
+	uint8_t bits = 8;
+	uint32_t speed = m_speedHz;
+	if(ioctl(m_spiFd, SPI_IOC_WR_MODE, &mode)<0 || ioctl(m_spiFd, SPI_IOC_WR_BITS_PER_WORD, &bits)<0 || ioctl(m_spiFd, SPI_IOC_WR_MAX_SPEED_HZ, &speed)<0){
+		Close();
+		return false;
+	}
+	// The least significant bit should be sent first, like on the AVR. Many controllers cannot do this, then the bits are reversed here.
+	uint8_t lsbFirst = 1;
+	m_reverseBits = ioctl(m_spiFd, SPI_IOC_WR_LSB_FIRST, &lsbFirst)<0;
+
+	if(m_latchLine>=0){
+		int chipFd = open(m_gpioChip, O_RDWR);
+		if(chipFd<0){
+			Close();
+			return false;
+		}
+		struct gpio_v2_line_request request;
+		memset(&request, 0, sizeof(request));
+		request.offsets[0] = m_latchLine;
+		request.num_lines = 1;
+		strncpy(request.consumer, "ShiftPWM latch", sizeof(request.consumer)-1);
+		request.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+		request.config.num_attrs = 1;
+		request.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+		request.config.attrs[0].attr.values = 0; // start low
+		request.config.attrs[0].mask = 1;
+		int result = ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &request);
+		close(chipFd);
+		if(result<0){
+			Close();
+			return false;
+		}
+		m_latchFd = request.fd;
+	}
+	return true;
+}
+
+void CShiftPWMSpidev::Close(void){
+	if(m_latchFd>=0){
+		close(m_latchFd);
+		m_latchFd = -1;
+	}
+	if(m_spiFd>=0){
+		close(m_spiFd);
+		m_spiFd = -1;
+	}
+}
+
+bool CShiftPWMSpidev::WriteLatch(int value){
+	struct gpio_v2_line_values values;
+	values.mask = 1;
+	values.bits = value ? 1 : 0;
+	return ioctl(m_latchFd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values)>=0;
+}
+
+const unsigned char * CShiftPWMSpidev::PrepareBytes(const unsigned char * bytes, unsigned int length){
+	if(!m_reverseBits){
+		return bytes;
+	}
+	m_reversed.resize(length);
+	for(unsigned int k=0; k<length; k++){
+		m_reversed[k] = reverseBits(bytes[k]);
+	}
+	return &m_reversed[0];
+}
+
+bool CShiftPWMSpidev::SendStep(const unsigned char * bytes, unsigned int length){
+	struct spi_ioc_transfer transfer;
+	memset(&transfer, 0, sizeof(transfer));
+	transfer.tx_buf = (unsigned long) PrepareBytes(bytes, length);
+	transfer.len = length;
+	transfer.speed_hz = m_speedHz;
+	transfer.bits_per_word = 8;
+	if(ioctl(m_spiFd, SPI_IOC_MESSAGE(1), &transfer)<0){
+		return false;
+	}
+	if(m_latchFd<0){
+		return true; // chip select went high at the end of the transfer, which latched the registers
+	}
+	// The rising edge latches the registers
+	return WriteLatch(1) && WriteLatch(0);
+}
+
+bool CShiftPWMSpidev::BatchesPeriods(void){
+	// Only possible with the latch on chip select: a GPIO cannot be written between the transfers of one message.
+	return m_latchFd<0;
+}
+
+bool CShiftPWMSpidev::SendPeriod(const unsigned char * bytes, unsigned int stepLength, unsigned int steps, unsigned long stepNanoseconds){
+	const unsigned char * tx = PrepareBytes(bytes, stepLength*steps);
+	// The kernel limits a message to 511 transfers and, by default, 4096 bytes (bufsiz parameter of the spidev module).
+	unsigned int maxSteps = 4096/stepLength;
+	if(maxSteps>511){
+		maxSteps = 511;
+	}
+	if(maxSteps==0){
+		maxSteps = 1;
+	}
+	// Wait after each transfer, so the steps are stepNanoseconds apart
+	unsigned long transferNanoseconds = (unsigned long long) stepLength*8*1000000000/m_speedHz;
+	unsigned short delay = (stepNanoseconds > transferNanoseconds) ? (stepNanoseconds-transferNanoseconds)/1000 : 0;
+
+	std::vector<struct spi_ioc_transfer> transfers;
+	for(unsigned int first=0; first<steps; first+=maxSteps){
+		unsigned int count = (steps-first < maxSteps) ? steps-first : maxSteps;
+		transfers.resize(count);
+		memset(&transfers[0], 0, count*sizeof(struct spi_ioc_transfer));
+		for(unsigned int k=0; k<count; k++){
+			transfers[k].tx_buf = (unsigned long) &tx[(first+k)*stepLength];
+			transfers[k].len = stepLength;
+			transfers[k].speed_hz = m_speedHz;
+			transfers[k].bits_per_word = 8;
+			transfers[k].delay_usecs = delay;
+			transfers[k].cs_change = (k+1<count); // chip select goes high between the steps, which latches them. It also goes high at the end.
+		}
+		if(ioctl(m_spiFd, SPI_IOC_MESSAGE(count), &transfers[0])<0){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+CShiftPWMFakeIO::CShiftPWMFakeIO(bool batchesPeriods) : m_batchesPeriods(batchesPeriods){
+	m_open = false;
+	m_transfers = 0;
+	pthread_mutex_init(&m_lock, 0);
+}
+
+CShiftPWMFakeIO::~CShiftPWMFakeIO(){
+	pthread_mutex_destroy(&m_lock);
+}
+
+bool CShiftPWMFakeIO::Open(void){
+	m_open = true;
+	return true;
+}
+
+void CShiftPWMFakeIO::Close(void){
+	m_open = false;
+}
+
+bool CShiftPWMFakeIO::IsOpen(void){
+	return m_open;
+}
+
+bool CShiftPWMFakeIO::SendStep(const unsigned char * bytes, unsigned int length){
+	pthread_mutex_lock(&m_lock);
+	m_steps.push_back(std::vector<unsigned char>(bytes, bytes+length));
+	m_transfers++;
+	pthread_mutex_unlock(&m_lock);
+	return true;
+}
+
+bool CShiftPWMFakeIO::BatchesPeriods(void){
+	return m_batchesPeriods;
+}
+
+bool CShiftPWMFakeIO::SendPeriod(const unsigned char * bytes, unsigned int stepLength, unsigned int steps, unsigned long){
+	pthread_mutex_lock(&m_lock);
+	for(unsigned int step=0; step<steps; step++){
+		m_steps.push_back(std::vector<unsigned char>(&bytes[step*stepLength], &bytes[(step+1)*stepLength]));
+	}
+	m_transfers++;
+	pthread_mutex_unlock(&m_lock);
+	return true;
+}
+
+std::vector< std::vector<unsigned char> > CShiftPWMFakeIO::Steps(void){
+	pthread_mutex_lock(&m_lock);
+	std::vector< std::vector<unsigned char> > steps = m_steps;
+	pthread_mutex_unlock(&m_lock);
+	return steps;
+}
+
+unsigned long CShiftPWMFakeIO::Transfers(void){
+	return m_transfers;
+}
+
+void CShiftPWMFakeIO::Clear(void){
+	pthread_mutex_lock(&m_lock);
+	m_steps.clear();
+	m_transfers = 0;
+	pthread_mutex_unlock(&m_lock);
+}
+
+unsigned int CShiftPWMFakeIO::OnSteps(int output, unsigned int first, unsigned int steps, bool invertOutputs){
+	// The first byte of a step is for the last register. Output k of a register is bit 7-k, see ShiftPWM_registerByte.
+	pthread_mutex_lock(&m_lock);
+	unsigned int on = 0;
+	for(unsigned int step=first; step<first+steps && step<m_steps.size(); step++){
+		const std::vector<unsigned char> & bytes = m_steps[step];
+		unsigned int reg = output/8;
+		if(reg >= bytes.size()){
+			continue;
+		}
+		bool bit = (bytes[bytes.size()-1-reg] >> (7-output%8)) & 1;
+		if(bit != invertOutputs){
+			on++;
+		}
+	}
+	pthread_mutex_unlock(&m_lock);
+	return on;
+}
@@ -0,0 +1,172 @@
+/*
+CShiftPWMLinux.h - Library for Arduino to PWM many outputs using shift registers
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+CShiftPWMLinux drives a chain of shift registers from a Linux board (Raspberry Pi, BeagleBone, ...), with all functions
+of the ShiftPWM object: SetOne, SetRGB, SetHSV, SetCurrentBudget, etc. The data is sent with the SPI device (/dev/spidevX.Y)
+and the latch is a GPIO, written with the GPIO character device (/dev/gpiochipN).
+
+Instead of one interrupt per step of the PWM counter, a real-time thread calculates all steps of a PWM period at once,
+with the same code that calculates the bytes in the interrupt on the AVR (ShiftPWM_registerByte in ShiftPWM_core.h).
+It then sends the steps at a fixed interval, each followed by a latch pulse.
+If the latch is connected to the chip select of the SPI port instead of a GPIO (latchLine -1), the whole period is sent
+as one batched transfer: the kernel sends all steps and raises chip select after each of them, which latches the registers.
+
+	#include "CShiftPWMLinux.h"
+
+	//                  SPI device,      SPI clock, GPIO chip,        latch line
+	CShiftPWMSpidev io("/dev/spidev0.0", 4000000,   "/dev/gpiochip0", 25);
+	CShiftPWMLinux pwm(io); // optional: invertOutputs, balanceLoad
+
+	int main(){
+		pwm.SetAmountOfRegisters(6);
+		pwm.Start(75, 63);
+		pwm.SetAllHSV(120, 255, 255);
+		...
+		pwm.Stop();
+	}
+
+Put the linux directory first on the include path, so its Arduino.h is used:
+	g++ -O2 -Ilinux -I. main.cpp CShiftPWM.cpp linux/Arduino.cpp linux/CShiftPWMLinux.cpp -lpthread
+
+Things to keep in mind:
+- With a GPIO latch, each step is a separate SPI transfer and two GPIO writes, which take 10-50 us on a typical board.
+  Use fewer brightness levels (31 or 63) or a lower frequency, or connect the latch to chip select.
+- The thread asks for real-time priority (SCHED_FIFO). Without permission (root or CAP_SYS_NICE), it runs at normal priority.
+- The values are locked while a period is calculated, with the cli() and SREG of linux/Arduino.h.
+- The matrix and hardware latch options of the AVR version are not supported. SetOffset rotates the values while a period
+  is calculated, and with SetIdleShutdown(true) the thread sends only one step and waits until a value changes.
+- CShiftPWMFakeIO records the steps instead of sending them, to test without hardware. See examples/ShiftPWM_Linux_FakeIO.cpp.
+*/
+
+#ifndef CShiftPWMLinux_h
+#define CShiftPWMLinux_h
+
+#include <Arduino.h>
+#include <pthread.h>
+#include <time.h>
+#include <vector>
+#include "CShiftPWM.h"
+
+// The device that the steps are sent to. A step is the byte of each register, the last register first.
+class CShiftPWMLinuxIO{
+public:
+	virtual ~CShiftPWMLinuxIO(){}
+	virtual bool Open(void) = 0;
+	virtual void Close(void) = 0;
+	// Sends one step and latches it.
+	virtual bool SendStep(const unsigned char * bytes, unsigned int length) = 0;
+	// Returns true if the device can send all steps of a period at once, stepNanoseconds apart, with SendPeriod.
+	virtual bool BatchesPeriods(void){ return false; }
+	virtual bool SendPeriod(const unsigned char *, unsigned int, unsigned int, unsigned long){ return false; }
+};
+
+// SPI device with a GPIO latch, or with the latch on chip select if latchLine is -1.
+class CShiftPWMSpidev : public CShiftPWMLinuxIO{
+public:
+	CShiftPWMSpidev(const char * spiDevice, unsigned long speedHz, const char * gpioChip = 0, int latchLine = -1);
+	~CShiftPWMSpidev();
+
+	bool Open(void);
+	void Close(void);
+	bool SendStep(const unsigned char * bytes, unsigned int length);
+	bool BatchesPeriods(void);
+	bool SendPeriod(const unsigned char * bytes, unsigned int stepLength, unsigned int steps, unsigned long stepNanoseconds);
+
+private:
+	bool WriteLatch(int value);
+	const unsigned char * PrepareBytes(const unsigned char * bytes, unsigned int length);
+
+	const char * m_spiDevice;
+	unsigned long m_speedHz;
+	const char * m_gpioChip;
+	int m_latchLine;
+	int m_spiFd;
+	int m_latchFd; // line request of the latch GPIO
+	bool m_reverseBits; // the SPI controller cannot send the least significant bit first
+	std::vector<unsigned char> m_reversed;
+};
+
+// Records the steps instead of sending them, to test CShiftPWMLinux without hardware.
+class CShiftPWMFakeIO : public CShiftPWMLinuxIO{
+public:
+	CShiftPWMFakeIO(bool batchesPeriods = false);
+	~CShiftPWMFakeIO();
+
+	bool Open(void);
+	void Close(void);
+	bool SendStep(const unsigned char * bytes, unsigned int length);
+	bool BatchesPeriods(void);
+	bool SendPeriod(const unsigned char * bytes, unsigned int stepLength, unsigned int steps, unsigned long stepNanoseconds);
+
+	// The recorded steps, and the number of SendStep and SendPeriod calls (transfers)
+	std::vector< std::vector<unsigned char> > Steps(void);
+	unsigned long Transfers(void);
+	void Clear(void);
+	bool IsOpen(void);
+	// Returns in how many of the steps first to first+steps-1 the output was on
+	unsigned int OnSteps(int output, unsigned int first, unsigned int steps, bool invertOutputs = false);
+
+private:
+	bool m_batchesPeriods;
+	bool m_open;
+	unsigned long m_transfers;
+	std::vector< std::vector<unsigned char> > m_steps;
+	pthread_mutex_t m_lock; // the steps are recorded by the thread of CShiftPWMLinux
+};
+
+class CShiftPWMLinux : public CShiftPWM{
+public:
+	CShiftPWMLinux(CShiftPWMLinuxIO & io, bool invertOutputs = false, bool balanceLoad = false, unsigned char * buffer = 0, unsigned int maxRegisters = 0);
+	~CShiftPWMLinux();
+
+	// Opens the device and starts the thread. Returns false if the device cannot be opened.
+	bool Start(int ledFrequency, unsigned char maxBrightness);
+	void Stop(void);
+
+	// Calculates and sends one period right away. The thread does this continuously, call it yourself only without Start.
+	void SendPeriod(void);
+	// Number of steps that were sent too late, because the thread was not scheduled in time.
+	unsigned long GetLateSteps(void);
+
+private:
+	bool CalculatePeriod(bool mayIdle);
+	void SendSteps(bool paced);
+	void WaitForStep(void);
+	static void * Thread(void * pwm);
+
+	CShiftPWMLinuxIO & m_io;
+	const bool m_invertOutputs;
+	const bool m_balanceLoad;
+
+	pthread_t m_thread;
+	bool m_threadStarted;
+	volatile bool m_running;
+
+	std::vector<unsigned char> m_period; // all steps of one period
+	std::vector<unsigned char> m_rotated; // the values in the order of the outputs, when an offset is set
+	unsigned int m_stepLength; // bytes per step
+	unsigned int m_steps;
+	unsigned long m_stepNanoseconds;
+	struct timespec m_nextStep;
+	unsigned long m_lateSteps;
+};
+
+#endif
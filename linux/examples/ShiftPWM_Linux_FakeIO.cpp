@@ -0,0 +1,166 @@
+/*
+ * ShiftPWM Linux example with a fake SPI device, (c) Elco Jacobs.
+ *
+ * This example runs CShiftPWMLinux without hardware. CShiftPWMFakeIO records the steps that would be sent to the SPI device,
+ * and the example checks that every output was on for exactly as many steps as its value, for each combination of options.
+ * It also checks a chain with a binary register between two PWM registers (see CShiftPWM::SetRegisterClasses), and that a new
+ * offset and a new amount of registers take effect while the outputs are idle (see CShiftPWM::SetIdleShutdown).
+ *
+ * Build and run from the ShiftPWM directory:
+ *	g++ -O2 -Ilinux -I. linux/examples/ShiftPWM_Linux_FakeIO.cpp CShiftPWM.cpp linux/Arduino.cpp linux/CShiftPWMLinux.cpp -lpthread -o fakeio
+ *	./fakeio
+ *
+ * To drive real shift registers, replace CShiftPWMFakeIO by CShiftPWMSpidev. See linux/CShiftPWMLinux.h.
+ */
+
+#include "CShiftPWMLinux.h"
+
+const int numRegisters = 3;
+
+static bool CheckLastPeriod(CShiftPWMFakeIO & io, CShiftPWMLinux & pwm, bool invertOutputs){
+	std::vector< std::vector<unsigned char> > steps = io.Steps();
+	unsigned int periodSteps = pwm.m_maxBrightness+1;
+	if(steps.size() < periodSteps || steps.size()%periodSteps != 0){
+		printf("  recorded %u steps, which is not a whole number of periods\n", (unsigned int) steps.size());
+		return false;
+	}
+	unsigned int first = steps.size()-periodSteps;
+	for(int output=0; output<numRegisters*8; output++){
+		unsigned int on = io.OnSteps(output, first, periodSteps, invertOutputs);
+		if(on != pwm.m_PWMValues[output]){
+			printf("  output %d was on for %u steps, expected %u\n", output, on, pwm.m_PWMValues[output]);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool RunTest(bool invertOutputs, bool balanceLoad, bool batched){
+	CShiftPWMFakeIO io(batched);
+	CShiftPWMLinux pwm(io, invertOutputs, balanceLoad);
+	// balanceLoad shifts the counter by 8 for each register, so all registers only get all counter values with 256 brightness levels.
+	unsigned char maxBrightness = balanceLoad ? 255 : 31;
+	pwm.SetAmountOfRegisters(numRegisters);
+	if(!pwm.Start(75, maxBrightness)){
+		printf("  Start failed\n");
+		return false;
+	}
+	for(int output=0; output<numRegisters*8; output++){
+		pwm.SetOne(output, (output*5)%(maxBrightness+1));
+	}
+	delay(100); // a few periods at 75 Hz
+	pwm.Stop();
+	bool passed = CheckLastPeriod(io, pwm, invertOutputs);
+	printf("  %lu transfers, %lu steps sent late, outputs were on for %lu ms in total\n", io.Transfers(), pwm.GetLateSteps(), pwm.GetOnTime());
+
+	// Without the thread, SendPeriod sends one period right away
+	io.Clear();
+	pwm.SetAll(maxBrightness/2);
+	pwm.SendPeriod();
+	return passed && CheckLastPeriod(io, pwm, invertOutputs);
+}
+
+static bool RunClassesTest(bool invertOutputs){
+	// Register 1 is a binary register, so PWM outputs 8-15 are on register 2 of the chain
+	CShiftPWMFakeIO io(false);
+	CShiftPWMLinux pwm(io, invertOutputs, false);
+	unsigned char maxBrightness = 31;
+	pwm.SetRegisterClasses("PBP");
+	if(pwm.m_amountOfOutputs != 16 || !pwm.Start(75, maxBrightness)){
+		printf("  SetRegisterClasses or Start failed\n");
+		return false;
+	}
+	pwm.Stop();
+	for(int output=0; output<16; output++){
+		pwm.SetOne(output, (output*5)%(maxBrightness+1));
+	}
+	pwm.SetBinaryRegister(0, 0xA5);
+	pwm.SetBinaryOutput(1, true);
+	io.Clear();
+	pwm.SendPeriod();
+	unsigned int periodSteps = maxBrightness+1;
+	for(int output=0; output<24; output++){
+		unsigned int on = io.OnSteps(output, 0, periodSteps, invertOutputs);
+		unsigned int expected;
+		if(output<8) expected = pwm.m_PWMValues[output];
+		else if(output<16) expected = ((0xA7>>(output-8)) & 1) ? periodSteps : 0;
+		else expected = pwm.m_PWMValues[output-8];
+		if(on != expected){
+			printf("  output %d of the chain was on for %u steps, expected %u\n", output, on, expected);
+			return false;
+		}
+	}
+	return pwm.GetBinaryOutput(1) && !pwm.GetBinaryOutput(3);
+}
+
+static bool LastStepIs(CShiftPWMFakeIO & io, unsigned int length, int onOutput){
+	// Checks the step that was latched before the thread went idle: only onOutput is on
+	std::vector< std::vector<unsigned char> > steps = io.Steps();
+	if(steps.empty() || steps.back().size() != length){
+		printf("  the last step has %u bytes, expected %u\n", steps.empty() ? 0 : (unsigned int) steps.back().size(), length);
+		return false;
+	}
+	unsigned int last = steps.size()-1;
+	for(int output=0; output<(int) length*8; output++){
+		if(io.OnSteps(output, last, 1, false) != (output==onOutput)){
+			printf("  output %d is %s in the last step\n", output, output==onOutput ? "off" : "on");
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool RunIdleTest(void){
+	CShiftPWMFakeIO io(false);
+	CShiftPWMLinux pwm(io, false, false);
+	unsigned char maxBrightness = 31;
+	pwm.SetAmountOfRegisters(2);
+	pwm.SetIdleShutdown(true);
+	if(!pwm.Start(75, maxBrightness)){
+		printf("  Start failed\n");
+		return false;
+	}
+	pwm.SetAll(0);
+	pwm.SetOne(0, maxBrightness);
+	delay(50);
+	bool passed = pwm.IsIdle() && LastStepIs(io, 2, 0);
+	// Output k shows value k+3, so the value of output 0 is shown on output 13
+	pwm.SetOffset(3);
+	delay(50);
+	passed = passed && pwm.IsIdle() && LastStepIs(io, 2, 13);
+	// The new register is sent as well, and the offset is kept: output 0 shows the value of output 3
+	pwm.SetAmountOfRegisters(3);
+	pwm.SetAll(0);
+	pwm.SetOne(3, maxBrightness);
+	delay(50);
+	passed = passed && pwm.IsIdle() && LastStepIs(io, 3, 0);
+	if(!pwm.IsIdle()){
+		printf("  the thread did not go idle\n");
+	}
+	pwm.Stop();
+	return passed;
+}
+
+int main(){
+	int failed = 0;
+	for(int options=0; options<8; options++){
+		bool invertOutputs = options & 1;
+		bool balanceLoad = options & 2;
+		bool batched = options & 4;
+		printf("invertOutputs %d, balanceLoad %d, batched periods %d\n", invertOutputs, balanceLoad, batched);
+		bool passed = RunTest(invertOutputs, balanceLoad, batched);
+		printf("  %s\n", passed ? "passed" : "FAILED");
+		failed += !passed;
+	}
+	for(int invertOutputs=0; invertOutputs<2; invertOutputs++){
+		printf("register classes PBP, invertOutputs %d\n", invertOutputs);
+		bool passed = RunClassesTest(invertOutputs);
+		printf("  %s\n", passed ? "passed" : "FAILED");
+		failed += !passed;
+	}
+	printf("idle shutdown with a new offset and amount of registers\n");
+	bool passed = RunIdleTest();
+	printf("  %s\n", passed ? "passed" : "FAILED");
+	failed += !passed;
+	return failed;
+}
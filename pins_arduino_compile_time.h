@@ -1,5 +1,5 @@
 #ifndef Pins_Arduino_Compile_Time_h
-#define Pins_Arduino_Compile_time_h
+#define Pins_Arduino_Compile_Time_h
 
 
 /* This is an alternative to pins_arduino.h
@@ -305,6 +305,61 @@ const uint8_t digital_pin_to_bit_PGM_ct[] = {
 	2,  3,  4,  5,  6,  7
 };
 
+#elif defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
+
+// ATMEL ATTINY25/45/85
+//
+//                  +-\/-+
+//      (D 5) PB5  1|    |8  VCC
+//      (D 3) PB3  2|    |7  PB2 (D 2) USCK
+//      (D 4) PB4  3|    |6  PB1 (D 1) DO
+//            GND  4|    |5  PB0 (D 0) DI
+//                  +----+
+
+volatile uint8_t * const port_to_output_PGM_ct[] = {
+	NOT_A_PORT, NOT_A_PORT, &PORTB
+};
+const uint8_t digital_pin_to_port_PGM_ct[] = {
+	PB, PB, PB, PB, PB, PB
+};
+const uint8_t digital_pin_to_bit_PGM_ct[] = {
+	0,  1,  2,  3,  4,  5
+};
+
+// The USI in three-wire mode is used instead of the SPI port, see ShiftPWM_spiWrite in ShiftPWM_core.h
+const uint8_t ShiftPWM_spiDataPin = 1; // DO
+const uint8_t ShiftPWM_spiClockPin = 2; // USCK
+
+#elif defined(__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84__)
+
+// ATMEL ATTINY24/44/84, counterclockwise pin numbering
+//
+//                   +-\/-+
+//             VCC  1|    |14  GND
+//     (D 10)  PB0  2|    |13  PA0  (D 0)
+//      (D 9)  PB1  3|    |12  PA1  (D 1)
+//     (D 11)  PB3  4|    |11  PA2  (D 2)
+//      (D 8)  PB2  5|    |10  PA3  (D 3)
+//      (D 7)  PA7  6|    |9   PA4  (D 4) USCK
+//   DO (D 5)  PA5  7|    |8   PA6  (D 6) DI
+//                   +----+
+
+volatile uint8_t * const port_to_output_PGM_ct[] = {
+	NOT_A_PORT, &PORTA, &PORTB
+};
+const uint8_t digital_pin_to_port_PGM_ct[] = {
+	PA, PA, PA, PA, PA, PA, PA, PA, PB, PB,
+	PB, PB
+};
+const uint8_t digital_pin_to_bit_PGM_ct[] = {
+	0,  1,  2,  3,  4,  5,  6,  7,  2,  1,
+	0,  3
+};
+
+// The USI in three-wire mode is used instead of the SPI port, see ShiftPWM_spiWrite in ShiftPWM_core.h
+const uint8_t ShiftPWM_spiDataPin = 5; // DO
+const uint8_t ShiftPWM_spiClockPin = 4; // USCK
+
 #else
 
 // these arrays map port names (e.g. port B) to the
@@ -368,5 +423,11 @@ const uint8_t digital_pin_to_bit_PGM_ct[] = {
 
 #endif
 
+#if !defined(USIDR) || defined(SPDR)
+// The pins that are used when noSPI is false: the data and clock pin of the SPI port
+const uint8_t ShiftPWM_spiDataPin = MOSI;
+const uint8_t ShiftPWM_spiClockPin = SCK;
+#endif
+
 
 #endif
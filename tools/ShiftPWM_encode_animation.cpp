@@ -0,0 +1,277 @@
+/*
+ShiftPWM_encode_animation.cpp - Encodes an animation for CShiftPWMAnimation
+Copyright (c) 2011-2012 Elco Jacobs, www.elcojacobs.com
+All right reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+This program runs on your computer, not on the Arduino. It reads the frames of an animation from a text file and writes
+a header file with the compressed show in program memory, for CShiftPWMAnimation (see CShiftPWMAnimation.h for the format).
+
+Build and run:
+	g++ -O2 tools/ShiftPWM_encode_animation.cpp -o encode_animation
+	./encode_animation frames.txt show.h -name show -periods 4 -loop 0
+
+The text file has one frame per line: the values of all outputs, 0-255, separated by spaces or commas.
+Empty lines and lines that start with # are skipped. All frames need the same amount of values.
+Options:
+	-name name		name of the array, default 'show'
+	-periods n		duration of each frame in PWM periods (1-255), default 1
+	-loop n			the frame to continue at after the last frame, default 0
+
+The show is decoded again after encoding, to check that it gives the same frames.
+The header file starts with the command and all options that made it, with the paths as they were given.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+typedef std::vector<unsigned char> Frame;
+
+static bool ReadFrames(const char * fileName, std::vector<Frame> & frames){
+	FILE * file = fopen(fileName, "r");
+	if(file==0){
+		fprintf(stderr, "Cannot open %s\n", fileName);
+		return false;
+	}
+	char line[65536];
+	int lineNumber = 0;
+	while(fgets(line, sizeof(line), file)){
+		lineNumber++;
+		char * p = line;
+		while(*p==' ' || *p=='\t') p++;
+		if(*p=='#' || *p=='\n' || *p=='\r' || *p==0){
+			continue;
+		}
+		Frame frame;
+		while(*p){
+			if(*p==' ' || *p=='\t' || *p==',' || *p=='\n' || *p=='\r'){
+				p++;
+				continue;
+			}
+			char * end;
+			long value = strtol(p, &end, 0);
+			if(end==p || value<0 || value>255){
+				fprintf(stderr, "%s:%d: values have to be numbers from 0 to 255\n", fileName, lineNumber);
+				fclose(file);
+				return false;
+			}
+			frame.push_back((unsigned char) value);
+			p = end;
+		}
+		if(!frames.empty() && frame.size()!=frames[0].size()){
+			fprintf(stderr, "%s:%d: %u values, the first frame has %u\n", fileName, lineNumber,
+			        (unsigned int) frame.size(), (unsigned int) frames[0].size());
+			fclose(file);
+			return false;
+		}
+		frames.push_back(frame);
+	}
+	fclose(file);
+	if(frames.empty() || frames[0].empty()){
+		fprintf(stderr, "%s has no frames\n", fileName);
+		return false;
+	}
+	return true;
+}
+
+// Length of the run of equal values at index
+static size_t RunLength(const Frame & frame, size_t index){
+	size_t end = index+1;
+	while(end<frame.size() && frame[end]==frame[index]) end++;
+	return end-index;
+}
+
+// Length of the run of values at index that did not change since the previous frame
+static size_t UnchangedLength(const Frame & frame, const Frame * previous, size_t index){
+	if(previous==0){
+		return 0;
+	}
+	size_t end = index;
+	while(end<frame.size() && frame[end]==(*previous)[end]) end++;
+	return end-index;
+}
+
+// Encodes one frame. Without a previous frame, all values are written, so the frame can be shown after any other frame.
+static void EncodeFrame(const Frame & frame, const Frame * previous, std::vector<unsigned char> & out){
+	size_t index = 0;
+	// Outputs at the end that do not change are not written at all
+	size_t last = frame.size();
+	if(previous!=0){
+		while(last>0 && frame[last-1]==(*previous)[last-1]) last--;
+	}
+	while(index<last){
+		size_t unchanged = UnchangedLength(frame, previous, index);
+		if(unchanged>0){
+			if(unchanged>127) unchanged = 127;
+			out.push_back((unsigned char) unchanged);
+			index += unchanged;
+			continue;
+		}
+		size_t run = RunLength(frame, index);
+		if(run>=3){
+			if(run>64) run = 64;
+			out.push_back(0xC0 | (unsigned char) (run-1));
+			out.push_back(frame[index]);
+			index += run;
+			continue;
+		}
+		// Different values, until a run or enough unchanged values to be worth a skip command
+		size_t count = 0;
+		while(index+count<last && count<64){
+			if(count>0 && (RunLength(frame, index+count)>=3 || UnchangedLength(frame, previous, index+count)>=3)){
+				break;
+			}
+			count++;
+		}
+		out.push_back(0x80 | (unsigned char) (count-1));
+		for(size_t k=0; k<count; k++){
+			out.push_back(frame[index+k]);
+		}
+		index += count;
+	}
+	out.push_back(0);
+}
+
+// Same as CShiftPWM::DecodeFrame_P
+static size_t DecodeFrame(const std::vector<unsigned char> & show, size_t position, Frame & frame){
+	size_t index = 0;
+	while(1){
+		unsigned char command = show[position++];
+		if(command==0){
+			break;
+		}
+		if(command<0x80){
+			index += command;
+			continue;
+		}
+		unsigned char count = (command & 0x3F)+1;
+		if(command & 0x40){
+			unsigned char value = show[position++];
+			for(; count>0; --count, ++index) if(index<frame.size()) frame[index] = value;
+		}
+		else{
+			for(; count>0; --count, ++index){
+				unsigned char value = show[position++];
+				if(index<frame.size()) frame[index] = value;
+			}
+		}
+	}
+	return position;
+}
+
+static void PutWord(std::vector<unsigned char> & out, size_t position, unsigned int value){
+	out[position] = value & 0xFF;
+	out[position+1] = value>>8;
+}
+
+int main(int argc, char * argv[]){
+	const char * input = 0;
+	const char * output = 0;
+	std::string name = "show";
+	int periods = 1;
+	int loopFrame = 0;
+	for(int k=1; k<argc; k++){
+		if(strcmp(argv[k], "-name")==0 && k+1<argc) name = argv[++k];
+		else if(strcmp(argv[k], "-periods")==0 && k+1<argc) periods = atoi(argv[++k]);
+		else if(strcmp(argv[k], "-loop")==0 && k+1<argc) loopFrame = atoi(argv[++k]);
+		else if(input==0) input = argv[k];
+		else if(output==0) output = argv[k];
+		else input = 0; // too many arguments, print the usage below
+	}
+	if(input==0 || output==0){
+		fprintf(stderr, "Usage: %s frames.txt show.h [-name show] [-periods 1] [-loop 0]\n", argv[0]);
+		return 1;
+	}
+	std::vector<Frame> frames;
+	if(!ReadFrames(input, frames)){
+		return 1;
+	}
+	if(periods<1 || periods>255){
+		fprintf(stderr, "-periods has to be 1-255\n");
+		return 1;
+	}
+	if(loopFrame<0 || loopFrame>=(int) frames.size()){
+		fprintf(stderr, "-loop has to be a frame number from 0 to %u\n", (unsigned int) frames.size()-1);
+		return 1;
+	}
+	if(frames.size()>65535 || frames[0].size()>65535){
+		fprintf(stderr, "Too many frames or outputs\n");
+		return 1;
+	}
+
+	std::vector<unsigned char> show(9, 0);
+	PutWord(show, 0, frames[0].size());
+	PutWord(show, 2, frames.size());
+	PutWord(show, 4, loopFrame);
+	show[8] = periods;
+	for(size_t f=0; f<frames.size(); f++){
+		if((int) f==loopFrame){
+			PutWord(show, 6, show.size());
+		}
+		// The first frame and the loop frame are complete, the others only contain the changes
+		bool complete = (f==0 || (int) f==loopFrame);
+		EncodeFrame(frames[f], complete ? 0 : &frames[f-1], show);
+	}
+	if(show.size()>65535){
+		fprintf(stderr, "The show is %u bytes, CShiftPWMAnimation can only play shows up to 64 kB\n", (unsigned int) show.size());
+		return 1;
+	}
+
+	// Check: decode the show twice, to include the jump to the loop frame
+	Frame decoded(frames[0].size(), 0);
+	size_t position = 9;
+	for(size_t f=0; f<frames.size()*2; f++){
+		size_t frameNumber = f;
+		if(f==frames.size()){
+			position = show[6] | (show[7]<<8);
+		}
+		if(f>=frames.size()){
+			frameNumber = loopFrame+(f-frames.size());
+			if(frameNumber>=frames.size()) break;
+		}
+		position = DecodeFrame(show, position, decoded);
+		if(decoded!=frames[frameNumber]){
+			fprintf(stderr, "Frame %u does not decode correctly\n", (unsigned int) frameNumber);
+			return 1;
+		}
+	}
+
+	FILE * file = fopen(output, "w");
+	if(file==0){
+		fprintf(stderr, "Cannot write %s\n", output);
+		return 1;
+	}
+	fprintf(file, "// Made with ShiftPWM_encode_animation from %s. Play it with CShiftPWMAnimation.\n", input);
+	// The exact command, so the show can be made again after changing the frames
+	fprintf(file, "// Regenerate with tools/ShiftPWM_encode_animation.cpp, in the directory it was made in:\n");
+	fprintf(file, "//\tencode_animation %s %s -name %s -periods %d -loop %d\n", input, output, name.c_str(), periods, loopFrame);
+	fprintf(file, "// %u frames of %u outputs, %u bytes (%u uncompressed)\n", (unsigned int) frames.size(), (unsigned int) frames[0].size(),
+	        (unsigned int) show.size(), (unsigned int) (frames.size()*frames[0].size()));
+	fprintf(file, "const unsigned char %s[] PROGMEM = {", name.c_str());
+	for(size_t k=0; k<show.size(); k++){
+		fprintf(file, "%s%s%u", (k==0) ? "" : ",", (k%20==0) ? "\n\t" : "", show[k]);
+	}
+	fprintf(file, "\n};\n");
+	fclose(file);
+	printf("%u frames, %u bytes (%u uncompressed)\n", (unsigned int) frames.size(), (unsigned int) show.size(),
+	       (unsigned int) (frames.size()*frames[0].size()));
+	return 0;
+}